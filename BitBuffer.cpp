@@ -43,8 +43,13 @@
 #endif
 
 #include "BitBuffer.h"
+#include "BitBufferSnapshot.h"
+#include "BitStream.h"
 #include "math.h"
 
+// compiler barrier for seqlock, keeps buffer accesses from being reordered across sequence updates
+#define BB_MEMORY_BARRIER() __asm__ __volatile__("" ::: "memory")
+
 // constant for ranges defining the maximum number of distinct values to be stored
 const byte BitBuffer::RANGE2 = 0x01;
 const byte BitBuffer::RANGE4 = 0x03;
@@ -67,6 +72,36 @@ const byte BitBuffer::OVERFLOW_MAX = 0x01;
 const byte BitBuffer::OVERFLOW_MIN = 0x02;
 const byte BitBuffer::OVERFLOW_SKIP = 0x03;
 
+// constants for watermark passed to watermark callback
+const byte BitBuffer::WATERMARK_LOW = 0x01;
+const byte BitBuffer::WATERMARK_HIGH = 0x02;
+
+// constants for scan operators
+const byte BitBuffer::SCAN_EQUAL = 0x01;
+const byte BitBuffer::SCAN_NOT_EQUAL = 0x02;
+const byte BitBuffer::SCAN_LESS = 0x03;
+const byte BitBuffer::SCAN_BETWEEN = 0x04;
+
+// constants for trigger mode
+const byte BitBuffer::TRIGGER_RISING = 0x01;
+const byte BitBuffer::TRIGGER_FALLING = 0x02;
+const byte BitBuffer::TRIGGER_WINDOW = 0x03;
+
+// constants for trigger state
+const byte BitBuffer::TRIGGER_ARMED = 0x01;
+const byte BitBuffer::TRIGGER_FIRED = 0x02;
+const byte BitBuffer::TRIGGER_COMPLETE = 0x03;
+
+// constants for archive reduction
+const byte BitBuffer::ARCHIVE_MIN = 0x01;
+const byte BitBuffer::ARCHIVE_MAX = 0x02;
+const byte BitBuffer::ARCHIVE_AVERAGE = 0x03;
+
+// constants for full policy
+const byte BitBuffer::FULL_OVERWRITE = 0x01;
+const byte BitBuffer::FULL_RESERVOIR = 0x02;
+const byte BitBuffer::FULL_DECIMATE = 0x03;
+
 byte s_range; //value range
 byte s_overflow; //overflow behaviour
 byte* s_data; //dataset array
@@ -81,7 +116,7 @@ boolean s_full; //keep state whether first overrun of FIFO happened already
  * p_range - defines the max values to be stored in the buffer, use the public constants
  * p_size - defines the number of entries in this FIFO store before data will be overwritten
  */
-BitBuffer::BitBuffer(byte p_range, unsigned int p_size) {
+BitBuffer::BitBuffer(byte p_range, unsigned int p_size) : s_writer(NULL, 0, 0) {
   #if BB_DEBUG_LEVEL > 0
   Serial.begin(9600);
   #endif
@@ -94,9 +129,28 @@ BitBuffer::BitBuffer(byte p_range, unsigned int p_size) {
   s_range = p_range;
   s_size = p_size;
   s_full = false;
+  s_valueCount = 0;
+  s_lowWatermark = 0;
+  s_highWatermark = 0;
+  s_risingWatermark = 0;
+  s_fallingWatermark = 0;
+  s_watermarkCallback = NULL;
+  s_reserveCount = 0;
+  s_writeCount = 0;
+  s_sequence = 0;
+  s_snapshots = NULL;
+  s_histogram = NULL;
+  s_statistics = NULL;
+  s_trigger = NULL;
+  s_archive = NULL;
+  s_fullPolicy = FULL_OVERWRITE;
+  s_seenCount = 0;
+  s_decimation = 1;
+  s_ttl = NULL;
   
   //TODO define maximum size to avoid buffer overflow - how to calculate avilable memory size...
   s_data = (byte*)malloc(getArraySize());
+  s_writer = BitWriter(s_data, 0, (unsigned long) getSize() * getBitSize());
   
   #if BB_DEBUG_LEVEL > 0
   Serial.print("Contructor::Array size: ");
@@ -108,9 +162,26 @@ BitBuffer::BitBuffer(byte p_range, unsigned int p_size) {
 
 /*
  * Resets buffer instance and frees memory
+ * Snapshots of the buffer copy all values they still reference beforehand and stay valid.
  */
 void BitBuffer::flush() {
+  if(s_snapshots != NULL)
+    preserveBytes(0, getArraySize() - 1);
+  
+  //snapshots do not access the buffer anymore once all pages are copied
+  while(s_snapshots != NULL)
+  {
+    BitBufferSnapshot* snapshot = s_snapshots;
+    s_snapshots = snapshot->s_next;
+    snapshot->s_buffer = NULL;
+  }
+  
   free(s_data);
+  disableHistogram();
+  disableStatistics();
+  disableTrigger();
+  setArchive(NULL, 0, 0);
+  disableTTL();
 }
 
 /*
@@ -133,220 +204,317 @@ unsigned int BitBuffer::getSize() {
 	return s_size;
 }
 
-// returns the number of values currently stored in buffer
+// returns the number of values currently stored in buffer, expired values are not counted but not removed either
 unsigned int BitBuffer::getValueCount() { 
-	return (s_full ? s_size : s_bitIndex / getBitSize()) - s_popCount;
+	if(s_ttl != NULL)
+		return getStoredCount() - getExpiredCount();
+	
+	return getStoredCount();
+}
+
+/*
+ * Watermark handling
+ * Defines fill levels (number of values in buffer) on which p_callback is called once the fill level
+ * reaches them while growing or drops below them while shrinking. A watermark of 0 is disabled, passing NULL
+ * as p_callback disables watermark handling.
+ */
+void BitBuffer::setWatermarks(unsigned int p_low, unsigned int p_high, void (*p_callback)(BitBuffer*, byte)) {
+	s_lowWatermark = p_low;
+	s_highWatermark = p_high;
+	s_watermarkCallback = p_callback;
+	updateWatermarks();
 }
 
 boolean BitBuffer::push(unsigned int p_value) {
-  // check if value is within defined range
-  if(p_value > getMaxRangeValue())
-  {
-    if(s_overflow == OVERFLOW_MAX)
-      p_value = getMaxRangeValue();
-    else if(s_overflow == OVERFLOW_MIN)
-      p_value = 0;
-    else
-      return false;
-  }
+  if(s_ttl != NULL)
+    expireValues();
   
-  //check if we reached end of capacity and overwrite old values
-  //as we have a defined size it might happen that there are still bits in the array left that will not be used
-  if(s_bitIndex + getBitSize() > getSize() * getBitSize())
-  {
-	  s_bitIndex = 0;
-	  s_full = true;
-  }
+  // check if value is within defined range and a complete capture is not to be overwritten
+  if(!mapToRange(&p_value) || (s_trigger != NULL && s_trigger->state == TRIGGER_COMPLETE))
+    return false;
   
-  //calculate position in byte array
-  int index = (int) (s_bitIndex / 8);
-  int offset = s_bitIndex % 8;
+  //statistics follow all values pushed, also those not sampled by the full policy
+  if(s_statistics != NULL)
+    updateStatistics(p_value);
   
-  #if BB_DEBUG_LEVEL > 1
-  Serial.print("Push::Index for push: ");
-  Serial.println(index);
-  #endif
+  //the full policy decides whether the value is appended, replaces a sampled one or is dropped
+  boolean stored;
+  if(s_fullPolicy != FULL_OVERWRITE && !sampleValue(p_value, &stored))
+    return stored;
   
-  byte *arrayValue = &s_data[index];
-  byte mask = 0xFF;
-  byte valueLow = ((byte *)&p_value)[0];
-  
-  if(getMaxRangeValue() <= RANGE256)
-  {    
-    //check if we are still in the same array index if we add the value
-    if(offset + getBitSize() <= 8)
-    {	
-      // bits new value to be added need to be shifted to the corresponding place, incorporating value already in dataset and size of value 
-	  valueLow = valueLow << (8 - offset - getBitSize());
-	  //create a mask that corresponds with the fields taken by value filled with 1
-	  mask = mask << (8 - getBitSize());
-	  mask = mask >> offset;
-	  
-      #if BB_DEBUG_LEVEL > 2
-	  Serial.print("Push::Mask non-inverted: ");
-	  Serial.println(mask);
-	  Serial.print("Push::Mask inverted: ");
-	  Serial.println(0xFF - mask);	  
-	  Serial.print("Push::Array value before: ");
-	  Serial.println(*arrayValue);
-	  #endif
-	  
-      // value stored before: 11000000, value new: 00001111, value shifted: 00111100, after storage: 11111100
-      // ensure that bits at location that value will be put to are reverted beforehand by using inverted mask
-	  *arrayValue = (*arrayValue & (0xFF - mask)) | valueLow;
-	  
-      #if BB_DEBUG_LEVEL > 2
-	  Serial.print("Push::Array value after: ");
-	  Serial.println(*arrayValue);
-	  #endif
-    }
-    else //<256 but beyond current byte for storing at current position
-    {
-		//TODO instead of two byte (v1, v2) overwrite v1
-      // value stored before: 11111000, value new: 00001111, value shifted1: 00000111, after storage1: 11111111, value shifted2/after storage2: 10000000
-      int overlength = offset + getBitSize() - 8;
-      byte v1 = valueLow >> overlength;
-	  mask = mask << (8 - getBitSize());
-	  mask = mask >> (8 - getBitSize() + overlength);
-	  
-	  #if BB_DEBUG_LEVEL > 2
-	  Serial.print("Push::Mask non-inverted: ");
-	  Serial.println(mask);
-	  Serial.print("Push::Mask inverted: ");
-	  Serial.println(0xFF - mask);	  
-	  Serial.print("Push::Value1: ");
-	  Serial.println(v1);
-	  #endif
-	  
-      *arrayValue = (*arrayValue & (0xFF - mask)) | v1;
-	  
-	  byte v2 = valueLow << (8 - overlength);
-      arrayValue = &s_data[index + 1];
-	  mask = 0xFF << (8 - overlength);
-	  
-	  #if BB_DEBUG_LEVEL > 2
-	  Serial.print("Push::Mask non-inverted: ");
-	  Serial.println(mask);
-	  Serial.print("Push::Mask inverted: ");
-	  Serial.println(0xFF - mask);	  
-	  Serial.print("Push::Value2: ");
-	  Serial.println(v2);
-	  #endif
-	  
-      *arrayValue = (*arrayValue & (0xFF - mask)) | v2;
-    }
-  }
-  else //>255
-  {
-	  // check whether value fits into current byte and next one
-	  if(offset + getBitSize() <= 16)
-	  {
-		  //TODO instead of two byte (v1, v2) overwrite v1
-		  // value stored before: 11100000|00000000, value new: 00000111|11111111, value shifted(v1|v2): 00011111|11111100, after storage: 11111111|11111111
-		  int overlength = offset + getBitSize() - 8;
-		  unsigned int valueIntShifted = p_value << (8 - overlength);
-		  byte v1 = ((byte *)&valueIntShifted)[1];
-		  
-		  mask = mask << 8 - (getBitSize() - 8) - (8 - overlength); //TODO to be replaced by 8 - offset???
-		  mask = mask >> 8 - (getBitSize() - 8) - (8 - overlength);
-		  
-		  #if BB_DEBUG_LEVEL > 2
-		  Serial.print("Push::Mask non-inverted: ");
-		  Serial.println(mask);
-		  Serial.print("Push::Value1: ");
-		  Serial.println(v1);
-		  #endif
-		  
-		  *arrayValue = (*arrayValue & (0xFF - mask)) | v1;
-		  
-		  byte v2 = ((byte *)&valueIntShifted)[0];
-		  arrayValue = &s_data[index + 1];
-		  mask = 0xFF << (8 - overlength);
-		  
-		  #if BB_DEBUG_LEVEL > 2
-		  Serial.print("Push::Mask non-inverted: ");
-		  Serial.println(mask);	  
-		  Serial.print("Push::Value2: ");
-		  Serial.println(v2);
-		  #endif
-		  
-		  *arrayValue = (*arrayValue & (0xFF - mask)) | v2;
-	  }
-	  else //>255 and value needs more space than the current and next byte
-	  {
-		  //TODO instead of two byte (v1, v2) overwrite v1
-		  int overlength = offset + getBitSize() - 16;
-		  
-		  //TODO TEST		  
-		  byte v1 = p_value >> getBitSize() - (8 - offset);
-		  
-		  mask = mask << offset;
-		  mask = mask >> offset;
-
-		  #if BB_DEBUG_LEVEL > 2
-		  Serial.print("Push::Mask non-inverted: ");
-		  Serial.println(mask);
-		  Serial.print("Push::Value1: ");
-		  Serial.println(v1);
-		  #endif
-		  
-		  *arrayValue = (*arrayValue & (0xFF - mask)) | v1;
-		  
-		  unsigned int valueIntShifted = p_value << (8 - offset) + (16 - getBitSize());
-		  byte v2 = ((byte *)&valueIntShifted)[1];
-		  mask = 0xFF;
-
-		  #if BB_DEBUG_LEVEL > 2
-		  Serial.print("Push::Value shifted (midByte, lowByte): ");
-		  Serial.println(valueIntShifted);
-		  Serial.print("Push::Mask non-inverted: ");
-		  Serial.println(mask);	  
-		  Serial.print("Push::Value2: ");
-		  Serial.println(v2);
-		  #endif
-		  
-		  arrayValue = &s_data[index + 1];
-		  *arrayValue = v2;
-		  
-		  byte v3 = ((byte *)&valueIntShifted)[0];
-		  mask = 0xFF << 8 - overlength;
-		  
-		  #if BB_DEBUG_LEVEL > 2
-		  Serial.print("Push::Mask non-inverted: ");
-		  Serial.println(mask);	  
-		  Serial.print("Push::Value3: ");
-		  Serial.println(v3);
-		  #endif
-		  
-		  arrayValue = &s_data[index + 2];
-		  *arrayValue = (*arrayValue & (0xFF - mask)) | v3;
-	  }	
-  }  
+  //only values appended are checked against the trigger, so values dropped by the full policy neither fire nor count as captured
+  if(s_trigger != NULL)
+    checkTrigger(p_value);
   
-  s_bitIndex = s_bitIndex + getBitSize();  
+  beginWrite();
   
-  if(s_popCount > 0) {
-	  s_popCount--;
-	  
-	  #if BB_DEBUG_LEVEL > 1
-	  Serial.print("Push::Decreased popCounter: ");
-	  Serial.println(s_popCount);
-	  #endif
+  //once the FIFO is full the oldest value is overwritten
+  if(hasHooks())
+  {
+    if(getStoredCount() == getSize())
+      valueRemoved(getValueInternal(getWriteBitIndex()), true);
+    valueAdded(p_value);
   }
   
+  if(s_ttl != NULL)
+    stampValue();
+  
+  setValueInternal(getWriteBitIndex(), p_value);
+  advanceBitIndex();
+  endWrite();
+  
+  //callbacks are called outside of the write section so that they are free to read from buffer
+  //the fill level grows by at most one, so it only reaches the next watermark by being equal to it
+  if(s_valueCount == s_risingWatermark)
+    checkWatermarks();
+  if(s_trigger != NULL)
+    completeTrigger();
+  
   return true;
 } //END push
 
+/*
+ * Two-phase write for producers filling the buffer directly instead of pushing value by value.
+ * reserve starts a write of up to p_count values at the current write position, write fills the reserved
+ * slots one after another (wrapping at the end of the buffer) and commit publishes the first p_count
+ * written values to getValue/pop at once. Values written but not committed are discarded by the next reserve.
+ * No other value may be pushed between reserve and commit.
+ * Once the FIFO is full the reserved slots contain the oldest values, write removes the oldest value from buffer like pop
+ * before overwriting its slot, so readers never see values not committed yet and slots reserved but not written cost no values.
+ *
+ * returns: number of reserved slots / whether value was written / number of published values
+ */
+unsigned int BitBuffer::reserve(unsigned int p_count) {
+	if(p_count > getSize())
+		p_count = getSize();
+	
+	//writes must not overwrite values in front of a trigger, as they are only checked on commit
+	if(s_trigger != NULL && p_count > getTriggerCapacity())
+		p_count = getTriggerCapacity();
+	
+	if(s_ttl != NULL)
+		expireValues();
+	
+	s_writer.seek(getWriteBitIndex());
+	s_reserveCount = p_count;
+	s_writeCount = 0;
+	
+	#if BB_DEBUG_LEVEL > 1
+	Serial.print("Reserve::Reserved values: ");
+	Serial.println(s_reserveCount);
+	#endif
+	
+	return p_count;
+} //END reserve
+
+boolean BitBuffer::write(unsigned int p_value) {
+	if(s_writeCount >= s_reserveCount || !mapToRange(&p_value))
+		return false;
+	
+	//values are collected in the accumulator of the writer and stored byte-wise, commit flushes the remaining bits
+	if(s_snapshots != NULL)
+	{
+		unsigned long bitIndex = s_writer.getBitIndex();
+		if(bitIndex + getBitSize() > (unsigned long) getSize() * getBitSize())
+			bitIndex = 0;
+		
+		preserveBytes(bitIndex / 8, (bitIndex + getBitSize() - 1) / 8);
+	}
+	
+	beginWrite();
+	
+	//once the free slots are written the oldest value leaves the buffer before its slot gets overwritten, commit checks the watermarks
+	if(getStoredCount() + s_writeCount >= getSize())
+	{
+		if(hasHooks())
+			valueRemoved(getValueInternal(getBitIndex(1)), true);
+		s_popCount++;
+		s_valueCount--;
+	}
+	
+	s_writer.write(p_value, getBitSize());
+	endWrite();
+	s_writeCount++;
+	
+	return true;
+} //END write
+
+unsigned int BitBuffer::commit(unsigned int p_count) {
+	if(p_count > s_writeCount)
+		p_count = s_writeCount;
+	
+	//remaining bits are merged into the byte at the write position
+	if(s_snapshots != NULL)
+		preserveBytes(s_writer.getBitIndex() / 8, s_writer.getBitIndex() / 8);
+	
+	//values are already in place, publishing them only moves the write position, readers see all of them or none
+	beginWrite();
+	s_writer.flush();
+	
+	for(unsigned int i = 0; i < p_count; i++)
+	{
+		unsigned int value = getValueInternal(getWriteBitIndex());
+		
+		//values behind a complete capture are discarded
+		if(s_trigger != NULL && !checkTrigger(value))
+		{
+			p_count = i;
+			break;
+		}
+		
+		if(s_statistics != NULL)
+			updateStatistics(value);
+		if(s_ttl != NULL)
+			stampValue();
+		if(hasHooks())
+			valueAdded(value);
+		
+		advanceBitIndex();
+	}
+	
+	endWrite();
+	
+	s_reserveCount = 0;
+	s_writeCount = 0;
+	
+	//callbacks are called once outside of the write section so that they are free to read from buffer
+	checkWatermarks();
+	if(s_trigger != NULL)
+		completeTrigger();
+	
+	#if BB_DEBUG_LEVEL > 1
+	Serial.print("Commit::Published values: ");
+	Serial.println(p_count);
+	#endif
+	
+	return p_count;
+} //END commit
+
+/*
+ * Bulk push of p_count values, values are streamed into the buffer by reserve/write/commit
+ * more values than the capacity are written in several rounds, so the buffer keeps the latest ones
+ *
+ * returns: number of values stored
+ */
+unsigned int BitBuffer::push(const unsigned int* p_values, unsigned int p_count) {
+	unsigned int count = 0;
+	
+	//sampling policies decide per value
+	if(s_fullPolicy != FULL_OVERWRITE)
+	{
+		for(unsigned int i = 0; i < p_count; i++)
+		{
+			if(push(p_values[i]))
+				count++;
+		}
+		
+		return count;
+	}
+	
+	while(p_count > 0)
+	{
+		unsigned int reserved = reserve(p_count);
+		unsigned int written = 0;
+		unsigned int consumed = 0;
+		
+		//nothing can be stored anymore once a capture is complete
+		if(reserved == 0)
+			break;
+		
+		//the oldest value is only removed by a value actually written, reserved slots of skipped values cost nothing
+		for(; consumed < p_count && written < reserved; consumed++)
+		{
+			if(write(p_values[consumed]))
+				written++;
+		}
+		
+		count += commit(written);
+		p_values += consumed;
+		p_count -= consumed;
+	}
+	
+	return count;
+} //END push(values, count)
+
+/*
+ * Pushes one frame of values into p_count buffers, p_values[i] into p_buffers[i]
+ * The write position of the first buffer in lockstep is mapped once to the byte index and the bit shift of the value
+ * within the (at most) 3 bytes covered, every buffer in lockstep takes the same bytes and shift. The first buffer is
+ * pushed last, so the others are compared against its position before it moves.
+ *
+ * returns: number of values stored
+ */
+unsigned int BitBuffer::push(BitBuffer** p_buffers, const unsigned int* p_values, unsigned int p_count) {
+	BitBuffer* first = NULL;
+	unsigned int firstValue = 0;
+	unsigned long byteIndex = 0;
+	byte shift = 0;
+	unsigned int count = 0;
+	
+	for(unsigned int i = 0; i < p_count; i++)
+	{
+		BitBuffer* buffer = p_buffers[i];
+		
+		//a buffer listed again moves on, so its pending value is pushed before and lockstep starts anew
+		if(buffer == first)
+		{
+			if(first->pushLockstep(firstValue, byteIndex, shift))
+				count++;
+			first = NULL;
+		}
+		
+		if(first == NULL && buffer->getSize() > 0 && buffer->isLockstep(buffer))
+		{
+			first = buffer;
+			firstValue = p_values[i];
+			
+			unsigned long bitIndex = first->getWriteBitIndex();
+			byteIndex = bitIndex / 8;
+			shift = 24 - bitIndex % 8 - first->getBitSize();
+		}
+		else if(first != NULL && first->isLockstep(buffer))
+		{
+			if(buffer->pushLockstep(p_values[i], byteIndex, shift))
+				count++;
+		}
+		else if(buffer->push(p_values[i]))
+		{
+			count++;
+		}
+	}
+	
+	if(first != NULL && first->pushLockstep(firstValue, byteIndex, shift))
+		count++;
+	
+	#if BB_DEBUG_LEVEL > 1
+	Serial.print("Push::Values stored of frame: ");
+	Serial.println(count);
+	#endif
+	
+	return count;
+} //END push(buffers, values, count)
+
 unsigned int BitBuffer::pop() {
 	unsigned int ret;
 	
+	if(s_ttl != NULL)
+		expireValues();
+	
 	//check whether any values in buffer left, if not we do not have a sufficient criteria to return error so we return 0
-	if(getValueCount() <= 0)
+	if(getStoredCount() <= 0)
 		return 0;
 	
-	ret = getValue(1);
+	ret = getValueInternal(getBitIndex(1));
 	
+	beginWrite();
 	s_popCount++;
+	s_valueCount--;
+	if(hasHooks())
+		valueRemoved(ret, true);
+	endWrite();
+	
+	if(s_valueCount < s_fallingWatermark)
+		checkWatermarks();
 	
 	#if BB_DEBUG_LEVEL > 1
 	Serial.print("Pop::Increased popCounter: ");
@@ -356,6 +524,119 @@ unsigned int BitBuffer::pop() {
 	return ret;
 } //END pop
 
+/*
+ * Double-ended access in addition to FIFO push/pop, e.g. for undoing the last values or displaying latest values first.
+ * pop_back removes the newest value, push_front adds a value in front of the oldest one as long as buffer is not full.
+ * The FIFO index of all other values is not changed by pop_back, but increased by one by push_front.
+ *
+ * returns: newest value in buffer / whether value was stored, false if it was skipped or buffer is full
+ */
+unsigned int BitBuffer::pop_back() {
+	if(s_ttl != NULL)
+		expireValues();
+	
+	//check whether any values in buffer left, if not we do not have a sufficient criteria to return error so we return 0
+	if(getStoredCount() == 0)
+		return 0;
+	
+	unsigned long bitIndex = getNewestBitIndex(1);
+	unsigned int ret = getValueInternal(bitIndex);
+	
+	//slot of newest value becomes the write position again, once FIFO is full the slot is counted as popped
+	beginWrite();
+	if(s_full)
+		s_popCount++;
+	s_valueCount--;
+	s_bitIndex = bitIndex;
+	if(s_ttl != NULL)
+		s_ttl->position = getStampPosition(1);
+	if(hasHooks())
+		valueRemoved(ret, false);
+	
+	//the next push rewrites the slot in place, readers have to read again as if the buffer was overwritten completely
+	s_sequence += 2 * getSize();
+	endWrite();
+	
+	if(s_valueCount < s_fallingWatermark)
+		checkWatermarks();
+	
+	#if BB_DEBUG_LEVEL > 1
+	Serial.print("PopBack::BitIndex: ");
+	Serial.println(s_bitIndex);
+	#endif
+	
+	return ret;
+} //END pop_back
+
+boolean BitBuffer::push_front(unsigned int p_value) {
+	if(s_ttl != NULL)
+		expireValues();
+	
+	// check if value is within defined range and a slot in front of the oldest value is free
+	if(!mapToRange(&p_value) || getStoredCount() >= getSize())
+		return false;
+	
+	beginWrite();
+	
+	//switch to the representation of a full FIFO, all slots not filled yet count as popped
+	if(!s_full)
+	{
+		s_popCount += getSize() - s_bitIndex / getBitSize();
+		s_full = true;
+	}
+	
+	s_popCount--;
+	s_valueCount++;
+	setValueInternal(getBitIndex(1), p_value);
+	
+	//a value starting a block of its own is as old as the value behind it, in an empty buffer it is stored now
+	if(s_ttl != NULL)
+	{
+		unsigned long position = getStampPosition(getStoredCount());
+		if(getStoredCount() == 1)
+			s_ttl->stamps[position / s_ttl->blockSize] = millis();
+		else if(position % s_ttl->blockSize == s_ttl->blockSize - 1)
+			s_ttl->stamps[position / s_ttl->blockSize] = s_ttl->stamps[getStampPosition(getStoredCount() - 1) / s_ttl->blockSize];
+	}
+	if(hasHooks())
+		valueAdded(p_value);
+	
+	endWrite();
+	
+	if(s_valueCount == s_risingWatermark)
+		checkWatermarks();
+	
+	return true;
+} //END push_front
+
+/*
+ * Returns the specified index in the buffer counted from the newest value without deleting it.
+ * The bit index is calculated from the write position directly, p_index 1 is the value pushed last.
+ *
+ * p_index: index starting with 1 for the newest value
+ * returns: value at specified index or 0 in case of invalid index
+ */
+unsigned int BitBuffer::getNewest(unsigned p_index) {
+	unsigned int sequence;
+	unsigned int ret = 0;
+	
+	//every write moves the newest values, so the value is read again after any write
+	do
+	{
+		sequence = readSequence();
+		if(sequence & 0x01)
+			continue;
+		
+		if(getValueCount() < p_index || p_index < 1)
+			ret = 0;
+		else
+			ret = getValueInternal(getNewestBitIndex(p_index));
+		
+		if(readSequence() == sequence)
+			return ret;
+	} while(true);
+} //END getNewest
+
 /*
  * Returns the specified index in the buffer without deleting it.
  * The index does not correspond with the internal bit-Index nor the array-Index but represents the
@@ -367,38 +648,628 @@ unsigned int BitBuffer::pop() {
  * returns: value at specified index or 0 in case of invalid index
  */
 unsigned int BitBuffer::getValue(unsigned p_index) {
-	//check whether index is currently filled in buffer
-	if(getValueCount() < p_index || p_index < 1)
+	unsigned int ret = 0;
+	
+	getValues(p_index, &ret, 1);
+	
+	return ret;
+} //END getValue
+
+/*
+ * Rewrites the value at the specified index in FIFO in place, e.g. to correct a sample after it was pushed.
+ * The value is mapped to the defined range according to overflow state like on push.
+ *
+ * p_index: index in FIFO starting with 1
+ * returns: whether value was stored, false if index is invalid or value was skipped
+ */
+boolean BitBuffer::setValue(unsigned int p_index, unsigned int p_value) {
+	if(s_ttl != NULL)
+		expireValues();
+	
+	if(getStoredCount() < p_index || p_index < 1 || !mapToRange(&p_value))
+		return false;
+	
+	beginWrite();
+	if(hasHooks())
+	{
+		valueRemoved(getValueInternal(getBitIndex(p_index)), false);
+		valueAdded(p_value);
+	}
+	setValueInternal(getBitIndex(p_index), p_value);
+	
+	//value is rewritten in place, readers have to read again as if the buffer was overwritten completely
+	s_sequence += 2 * getSize();
+	endWrite();
+	
+	return true;
+} //END setValue
+
+/*
+ * Atomic read-modify-write of the value at the specified index in FIFO. p_function is called with the current value
+ * and returns the new one, which is mapped to the defined range according to overflow state (skipped values leave
+ * the current one in place). Interrupts are disabled meanwhile, so an interrupt routine writing to the buffer
+ * cannot interfere; readers see either the current or the new value.
+ *
+ * p_index: index in FIFO starting with 1
+ * returns: value before update or 0 in case of invalid index
+ */
+unsigned int BitBuffer::updateValue(unsigned int p_index, unsigned int (*p_function)(unsigned int)) {
+	unsigned int ret = 0;
+	
+	BB_ATOMIC_BLOCK
+	{
+		if(s_ttl != NULL)
+			expireValues();
+		
+		if(getStoredCount() >= p_index && p_index >= 1)
+		{
+			unsigned long bitIndex = getBitIndex(p_index);
+			ret = getValueInternal(bitIndex);
+			
+			unsigned int value = p_function(ret);
+			if(mapToRange(&value))
+			{
+				beginWrite();
+				if(hasHooks())
+				{
+					valueRemoved(ret, false);
+					valueAdded(value);
+				}
+				setValueInternal(bitIndex, value);
+				s_sequence += 2 * getSize();
+				endWrite();
+			}
+		}
+	}
+	
+	return ret;
+} //END updateValue
+
+/*
+ * Consistent retrieval of p_count values starting at the specified index in FIFO without deleting them,
+ * while another context (e.g. an interrupt routine) keeps pushing values (single writer, multiple readers).
+ * Readers do not lock, they take an optimistic snapshot of the buffer state guarded by a sequence counter
+ * which is odd while the writer changes the buffer. The values are decoded from the snapshot and only read
+ * again if the writer meanwhile wrapped over the first value read, pushing into free slots does not harm.
+ * Writes rewriting values in place (setValue, updateValue, ...) advance the sequence by 2 * getSize(),
+ * so every reader overlapping them reads again.
+ *
+ * p_index: index in FIFO starting with 1
+ * returns: number of values written to p_values
+ */
+unsigned int BitBuffer::getValues(unsigned p_index, unsigned int* p_values, unsigned int p_count) {
+	unsigned int sequence;
+	unsigned int freeCount;
+	unsigned int writeCount;
+	
+	do
+	{
+		//wait for writer to finish, as writer is an interrupt routine or runs on another core this does not block
+		sequence = readSequence();
+		if(sequence & 0x01)
+			continue;
+		
+		//index is counted from the newest value, so expired values in front are skipped
+		unsigned int count = getValueCount();
+		unsigned long bitIndex = getNewestBitIndex(count - p_index + 1);
+		freeCount = getSize() - count;
+		
+		//check whether state was changed while taking the snapshot
+		if(readSequence() != sequence)
+			continue;
+		
+		//check whether index is currently filled in buffer
+		if(count < p_index || p_index < 1)
+			return 0;
+		
+		if(p_count > count - p_index + 1)
+			p_count = count - p_index + 1;
+		
+		BitReader reader(s_data, bitIndex, (unsigned long) getSize() * getBitSize());
+		
+		for(unsigned int i = 0; i < p_count; i++)
+			p_values[i] = reader.read(getBitSize());
+		
+		//number of writes since snapshot including an ongoing one, writer fills free slots before the oldest value is overwritten
+		writeCount = (readSequence() - sequence + 1) / 2;
+		
+		if(writeCount <= freeCount || writeCount - freeCount < p_index)
+			return p_count;
+		
+		#if BB_DEBUG_LEVEL > 1
+		Serial.print("GetValues::Retry after writes: ");
+		Serial.println(writeCount);
+		#endif
+	} while(true);
+} //END getValues
+
+/*
+ * Batch retrieval for consumers draining the buffer in one go instead of calling pop for every value.
+ * The FIFO index is mapped to the bit index only once, afterwards values are streamed out of the ring by a BitReader.
+ *
+ * p_values: array receiving the values in FIFO order
+ * p_count: maximum number of values to be retrieved
+ * returns: number of values written to p_values and removed from buffer
+ */
+unsigned int BitBuffer::pop(unsigned int* p_values, unsigned int p_count) {
+	if(s_ttl != NULL)
+		expireValues();
+	
+	if(p_count > getStoredCount())
+		p_count = getStoredCount();
+	
+	if(p_count == 0)
 		return 0;
 	
-	unsigned long bitDelta = (getValueCount() - p_index + 1) * getBitSize();
-	unsigned long bitIndex;
+	BitReader reader(s_data, getBitIndex(1), (unsigned long) getSize() * getBitSize());
 	
-	// check if we have to take the value from the end of the buffer
-	if(bitDelta <= s_bitIndex)
-		bitIndex = s_bitIndex - bitDelta;
-	else
-		bitIndex = getSize() * getBitSize() - bitDelta + s_bitIndex;
+	for(unsigned int i = 0; i < p_count; i++)
+		p_values[i] = reader.read(getBitSize());
+	
+	beginWrite();
+	s_popCount += p_count;
+	s_valueCount -= p_count;
+	for(unsigned int i = 0; i < p_count && hasHooks(); i++)
+		valueRemoved(p_values[i], true);
+	endWrite();
+	
+	if(s_valueCount < s_fallingWatermark)
+		checkWatermarks();
 	
 	#if BB_DEBUG_LEVEL > 1
-	Serial.print("GetValue::Value count: ");
-	Serial.println(getValueCount());
-	Serial.print("GetValue::BitDelta: ");
-	Serial.println(bitDelta);
-	Serial.print("GetValue::Current BitIndex: ");
-	Serial.println(s_bitIndex);
-	Serial.print("GetValue::Value BitIndex: ");
-	Serial.println(bitIndex);
+	Serial.print("Pop::Increased popCounter: ");
+	Serial.println(s_popCount);
 	#endif
 	
-	return getValueInternal(bitIndex);	
-} //END getValue
+	return p_count;
+} //END pop(values, count)
 
-#if BB_DEBUG_LEVEL > 0
-void BitBuffer::runTest() {
-	//TODO do this for all ranges
-	for(int k = 0; k < 15; k++)
-	{
+/*
+ * Readiness based batch retrieval, removes exactly p_count values or none while less are in buffer
+ * returns: p_count if values were written to p_values and removed from buffer, 0 otherwise
+ */
+unsigned int BitBuffer::popIfAvailable(unsigned int* p_values, unsigned int p_count) {
+	if(s_ttl != NULL)
+		expireValues();
+	
+	if(p_count == 0 || getStoredCount() < p_count)
+		return 0;
+	
+	return pop(p_values, p_count);
+} //END popIfAvailable
+
+/*
+ * Predicate scan over all values in buffer
+ * For value sizes dividing 32 bit the values never cross a word boundary, so 32 bit of the array are loaded at once and
+ * compared lane-wise (SWAR) against the constant repeated for every value. Bits of the word outside of the values in buffer
+ * are masked. Other value sizes are decoded value by value.
+ *
+ * p_bitmap: optional array of (getValueCount() + 7) / 8 bytes receiving one bit per value in FIFO order
+ * returns: number of values matching
+ */
+unsigned int BitBuffer::scan(byte p_operator, unsigned int p_value, unsigned int p_upper, byte* p_bitmap) {
+	unsigned long bitIndex[2];
+	unsigned long bitCount[2];
+	unsigned int count = 0;
+	unsigned int index = 0;
+	
+	//cleared before the window is taken, values only expire meanwhile, so the window never exceeds the bitmap cleared
+	if(p_bitmap != NULL)
+		memset(p_bitmap, 0, (getValueCount() + 7) / 8);
+	
+	byte windowCount = getWindow(bitIndex, bitCount);
+	
+	if(32 % getBitSize() != 0)
+	{
+		BitReader reader(s_data, 0, 0);
+		
+		for(byte window = 0; window < windowCount; window++)
+		{
+			reader.seek(bitIndex[window]);
+			
+			for(unsigned long i = bitCount[window] / getBitSize(); i > 0; i--, index++)
+			{
+				unsigned int value = reader.read(getBitSize());
+				boolean match;
+				
+				if(p_operator == SCAN_EQUAL)
+					match = value == p_value;
+				else if(p_operator == SCAN_NOT_EQUAL)
+					match = value != p_value;
+				else if(p_operator == SCAN_LESS)
+					match = value < p_value;
+				else
+					match = value >= p_value && value <= p_upper;
+				
+				if(match)
+				{
+					count++;
+					if(p_bitmap != NULL)
+						p_bitmap[index / 8] |= 0x80 >> (index % 8);
+				}
+			}
+		}
+		
+		return count;
+	}
+	
+	//constants are limited to the range, values beyond can be decided without lane comparison
+	unsigned int maxValue = getMaxRangeValue();
+	if(p_operator == SCAN_LESS && p_value > maxValue)
+	{
+		p_operator = SCAN_NOT_EQUAL;
+		p_value = maxValue + 1;
+	}
+	if(p_operator == SCAN_BETWEEN && p_upper > maxValue)
+		p_upper = maxValue;
+	
+	//lowest bit of every value set, multiplying a value with it repeats the value in every lane
+	uint32_t lowBits = 0xFFFFFFFFUL / ((1UL << getBitSize()) - 1);
+	uint32_t highBits = lowBits << (getBitSize() - 1);
+	uint32_t value = (uint32_t) (p_value > maxValue ? 0 : p_value) * lowBits;
+	uint32_t upper = (uint32_t) p_upper * lowBits;
+	boolean never = (p_value > maxValue && p_operator != SCAN_NOT_EQUAL) || (p_operator == SCAN_BETWEEN && p_value > p_upper);
+	boolean always = p_value > maxValue && p_operator == SCAN_NOT_EQUAL;
+	
+	for(byte window = 0; window < windowCount; window++)
+	{
+		unsigned long end = bitIndex[window] + bitCount[window];
+		
+		for(unsigned long wordIndex = bitIndex[window] & ~31UL; wordIndex < end; wordIndex += 32)
+		{
+			uint32_t flags;
+			if(never || always)
+				flags = never ? 0 : highBits;
+			else
+				flags = matchLanes(getWord(wordIndex), p_operator, value, upper, highBits);
+			
+			//mask bits of values outside of the window
+			byte first = wordIndex < bitIndex[window] ? bitIndex[window] - wordIndex : 0;
+			byte last = end - wordIndex < 32 ? end - wordIndex : 32;
+			flags &= 0xFFFFFFFFUL >> first;
+			if(last < 32)
+				flags &= ~(0xFFFFFFFFUL >> last);
+			
+			count += __builtin_popcountl(flags);
+			
+			if(p_bitmap != NULL)
+			{
+				for(byte bit = first; bit < last; bit += getBitSize(), index++)
+				{
+					if(flags & (0x80000000UL >> bit))
+						p_bitmap[index / 8] |= 0x80 >> (index % 8);
+				}
+			}
+		}
+	}
+	
+	#if BB_DEBUG_LEVEL > 1
+	Serial.print("Scan::Matching values: ");
+	Serial.println(count);
+	#endif
+	
+	return count;
+} //END scan
+
+/*
+ * Aggregates over all values in buffer without retrieving them, getMin and getMax return 0 for an empty buffer
+ * p_counts: array of p_binCount counters receiving the histogram, the range of values is split into p_binCount bins of equal size
+ */
+unsigned long BitBuffer::getSum() {
+	unsigned long sum;
+	aggregate(&sum, NULL, NULL, NULL, 0);
+	return sum;
+}
+
+unsigned int BitBuffer::getMin() {
+	unsigned int minValue;
+	aggregate(NULL, &minValue, NULL, NULL, 0);
+	return minValue;
+}
+
+unsigned int BitBuffer::getMax() {
+	unsigned int maxValue;
+	aggregate(NULL, NULL, &maxValue, NULL, 0);
+	return maxValue;
+}
+
+void BitBuffer::getHistogram(unsigned int* p_counts, unsigned int p_binCount) {
+	aggregate(NULL, NULL, NULL, p_counts, p_binCount);
+}
+
+/*
+ * Incrementally maintained histogram for ranges up to RANGE256
+ * The number of values per value is kept in a Fenwick tree (binary indexed tree): node i holds the number of values
+ * within the i & -i values up to i, so updating a value and summing up the values below touch log(range) nodes each.
+ *
+ * returns: whether histogram could be enabled, false if range is beyond RANGE256 or memory is exhausted
+ */
+boolean BitBuffer::enableHistogram() {
+	if(s_histogram != NULL)
+		return true;
+	
+	if(getBitSize() > 8)
+		return false;
+	
+	s_histogram = (unsigned int*)malloc((getMaxRangeValue() + 1) * sizeof(unsigned int));
+	if(s_histogram == NULL)
+		return false;
+	
+	rebuildHistogram();
+	return true;
+} //END enableHistogram
+
+void BitBuffer::disableHistogram() {
+	free(s_histogram);
+	s_histogram = NULL;
+}
+
+// counts all values in buffer again
+void BitBuffer::rebuildHistogram() {
+	if(s_histogram == NULL)
+		return;
+	
+	//counts per value are converted into the tree in place, each node adds its sum to its parent
+	unsigned int nodeCount = getMaxRangeValue() + 1;
+	getHistogram(s_histogram, nodeCount);
+	
+	for(unsigned int node = 1; node <= nodeCount; node++)
+	{
+		unsigned int parent = node + (node & -node);
+		if(parent <= nodeCount)
+			s_histogram[parent - 1] += s_histogram[node - 1];
+	}
+} //END rebuildHistogram
+
+/*
+ * Returns the smallest value for which at least p_percent of the values in buffer are less or equal, e.g. 50 for the median
+ * The tree is descended from the largest power of two, skipping all nodes whose values are below the requested rank.
+ * returns: quantile or 0 if buffer is empty or histogram is not enabled
+ */
+unsigned int BitBuffer::getQuantile(byte p_percent) {
+	if(s_histogram == NULL || getStoredCount() == 0)
+		return 0;
+	
+	if(p_percent > 100)
+		p_percent = 100;
+	
+	//rank of the value, at least the first one, the histogram counts expired values until they are removed
+	unsigned long rank = ((unsigned long) getStoredCount() * p_percent + 99) / 100;
+	if(rank == 0)
+		rank = 1;
+	
+	unsigned int nodeCount = getMaxRangeValue() + 1;
+	unsigned int position = 0;
+	unsigned int step = 1;
+	while(step * 2 <= nodeCount)
+		step *= 2;
+	
+	for(; step > 0; step /= 2)
+	{
+		if(position + step <= nodeCount && s_histogram[position + step - 1] < rank)
+		{
+			position += step;
+			rank -= s_histogram[position - 1];
+		}
+	}
+	
+	return position;
+} //END getQuantile
+
+/*
+ * Streaming statistics of all values pushed, each value pushed is weighted by 2^-p_shift against the history
+ * returns: whether statistics could be enabled, false if memory is exhausted
+ */
+boolean BitBuffer::enableStatistics(byte p_shift) {
+	if(s_statistics == NULL)
+		s_statistics = (Statistics*)malloc(sizeof(Statistics));
+	
+	if(s_statistics == NULL)
+		return false;
+	
+	s_statistics->shift = p_shift > 15 ? 15 : p_shift;
+	s_statistics->fraction = 16 - getBitSize();
+	s_statistics->initialized = false;
+	return true;
+}
+
+void BitBuffer::disableStatistics() {
+	free(s_statistics);
+	s_statistics = NULL;
+}
+
+// statistics are converted from fixed point on request only
+float BitBuffer::getAverage() {
+	if(s_statistics == NULL)
+		return 0;
+	
+	return ldexp(s_statistics->average, -s_statistics->fraction);
+}
+
+float BitBuffer::getVariance() {
+	if(s_statistics == NULL)
+		return 0;
+	
+	return ldexp(s_statistics->variance, -2 * s_statistics->fraction);
+}
+
+float BitBuffer::getRate() {
+	if(s_statistics == NULL)
+		return 0;
+	
+	return ldexp(s_statistics->rate, -s_statistics->fraction);
+}
+
+/*
+ * Trigger handling, the trigger is checked on push and stays disarmed until armTrigger is called
+ * returns: whether trigger could be set, false if memory is exhausted
+ */
+boolean BitBuffer::setTrigger(byte p_mode, unsigned int p_level, unsigned int p_upper, void (*p_callback)(BitBuffer*)) {
+	if(s_trigger == NULL)
+		s_trigger = (Trigger*)malloc(sizeof(Trigger));
+	
+	if(s_trigger == NULL)
+		return false;
+	
+	s_trigger->mode = p_mode;
+	s_trigger->level = p_level;
+	s_trigger->upper = p_upper;
+	s_trigger->callback = p_callback;
+	s_trigger->state = 0;
+	return true;
+}
+
+void BitBuffer::disableTrigger() {
+	free(s_trigger);
+	s_trigger = NULL;
+}
+
+/*
+ * Arms the trigger for capturing p_preCount values in front of and p_postCount values after the value firing the trigger
+ * returns: whether trigger could be armed
+ */
+boolean BitBuffer::armTrigger(unsigned int p_preCount, unsigned int p_postCount) {
+	if(s_trigger == NULL || (unsigned long) p_preCount + p_postCount + 1 > getSize())
+		return false;
+	
+	s_trigger->preCount = p_preCount;
+	s_trigger->postCount = p_postCount;
+	s_trigger->captured = 0;
+	s_trigger->hasLastValue = false;
+	s_trigger->state = TRIGGER_ARMED;
+	return true;
+}
+
+byte BitBuffer::getTriggerState() {
+	return s_trigger == NULL ? 0 : s_trigger->state;
+}
+
+/*
+ * Full policy
+ * Defines what happens to values pushed once the buffer is full, see BitBuffer.h. Setting the policy restarts sampling
+ * with the values currently in buffer.
+ */
+byte BitBuffer::getFullPolicy() {
+	return s_fullPolicy;
+}
+
+void BitBuffer::setFullPolicy(byte p_policy) {
+	s_fullPolicy = p_policy;
+	s_seenCount = getValueCount();
+	s_decimation = 1;
+}
+
+// returns the number of values pushed per value stored since decimation started
+unsigned int BitBuffer::getDecimation() {
+	return s_decimation;
+}
+
+/*
+ * Time-based expiry, values older than p_ttl milliseconds are removed
+ * Values are grouped in the order they were appended into blocks of p_blockSize values sharing one timestamp, the time
+ * of the latest value stored in the block. Values in buffer span at most one block more than the buffer holds, so the
+ * blocks are reused once all their values left the buffer.
+ * returns: whether expiry could be enabled, false if memory is exhausted
+ */
+boolean BitBuffer::enableTTL(unsigned long p_ttl, unsigned int p_blockSize) {
+	if(p_blockSize < 1)
+		p_blockSize = 1;
+	
+	unsigned int blockCount = (getSize() + p_blockSize - 1) / p_blockSize + 1;
+	TTL* ttl = (TTL*)realloc(s_ttl, sizeof(TTL) + (blockCount - 1) * sizeof(unsigned long));
+	if(ttl == NULL)
+		return false;
+	
+	//values already in buffer count as stored now
+	ttl->ttl = p_ttl;
+	ttl->blockSize = p_blockSize;
+	ttl->blockCount = blockCount;
+	ttl->position = getStoredCount();
+	ttl->expired = 0;
+	for(unsigned int i = 0; i < blockCount; i++)
+		ttl->stamps[i] = millis();
+	
+	s_ttl = ttl;
+	return true;
+} //END enableTTL
+
+void BitBuffer::disableTTL() {
+	free(s_ttl);
+	s_ttl = NULL;
+}
+
+/*
+ * Archive handling
+ * Reduces blocks of p_blockSize values by p_function and pushes the result into p_archive, values are scaled to the range of the archive.
+ * Passing NULL as p_archive disables the archive, values of a block not complete yet are discarded.
+ * returns: whether archive could be set, false if memory is exhausted
+ */
+boolean BitBuffer::setArchive(BitBuffer* p_archive, unsigned int p_blockSize, byte p_function) {
+	if(p_archive == NULL || p_blockSize == 0)
+	{
+		free(s_archive);
+		s_archive = NULL;
+		return true;
+	}
+	
+	//a cascade leading back to this buffer would push evicted values around in circles
+	for(BitBuffer* buffer = p_archive; buffer != NULL; buffer = buffer->s_archive != NULL ? buffer->s_archive->buffer : NULL)
+	{
+		if(buffer == this)
+			return false;
+	}
+	
+	if(s_archive == NULL)
+		s_archive = (Archive*)malloc(sizeof(Archive));
+	
+	if(s_archive == NULL)
+		return false;
+	
+	s_archive->buffer = p_archive;
+	s_archive->blockSize = p_blockSize;
+	s_archive->function = p_function;
+	s_archive->shift = (int) p_archive->getBitSize() - (int) getBitSize();
+	s_archive->count = 0;
+	return true;
+} //END setArchive
+
+/*
+ * Returns the finest buffer of the cascade whose values together with all finer buffers cover p_span values pushed
+ * into this buffer, or the coarsest one if the span is not covered completely
+ *
+ * p_resolution: receives the number of values pushed into this buffer per value of the buffer returned, may be NULL
+ */
+BitBuffer* BitBuffer::getArchive(unsigned long p_span, unsigned long* p_resolution) {
+	BitBuffer* buffer = this;
+	unsigned long resolution = 1;
+	unsigned long covered = getValueCount();
+	
+	while(covered < p_span && buffer->s_archive != NULL)
+	{
+		resolution *= buffer->s_archive->blockSize;
+		buffer = buffer->s_archive->buffer;
+		covered += (unsigned long) buffer->getValueCount() * resolution;
+	}
+	
+	if(p_resolution != NULL)
+		*p_resolution = resolution;
+	
+	return buffer;
+} //END getArchive
+
+// values popped meanwhile move the trigger to the front like any other value
+unsigned int BitBuffer::getTriggerIndex() {
+	if(s_trigger == NULL || s_trigger->state < TRIGGER_FIRED || getValueCount() <= s_trigger->captured)
+		return 0;
+	
+	return getValueCount() - s_trigger->captured;
+}
+
+#if BB_DEBUG_LEVEL > 0
+void BitBuffer::runTest() {
+	//TODO do this for all ranges
+	for(int k = 0; k < 15; k++)
+	{
 		byte range;
 		unsigned int maxVal;
 		
@@ -515,6 +1386,23 @@ void BitBuffer::runTest() {
 		Serial.println("");
 		buffer.printContent2Serial();
 	}
+
+	//bulk push into a full buffer, skipped values must not remove stored ones
+	BitBuffer bulk(BitBuffer::RANGE16, 8);
+	bulk.setOverflowState(BitBuffer::OVERFLOW_SKIP);
+	for(unsigned int i = 0; i < 8; i++)
+		bulk.push(i);
+
+	unsigned int values[] = {100, 100, 5};
+	unsigned int expected[] = {1, 2, 3, 4, 5, 6, 7, 5};
+	boolean passed = bulk.push(values, 3) == 1 && bulk.getValueCount() == 8;
+	for(unsigned int i = 0; passed && i < 8; i++)
+		passed = bulk.getValue(i + 1) == expected[i];
+
+	Serial.println("\n--------------------------------------");
+	Serial.print("Bulk push with skipped values into full buffer: ");
+	Serial.println(passed ? "passed" : "FAILED");
+	bulk.printContent2Serial();
 }
 #endif
 
@@ -589,7 +1477,7 @@ unsigned int BitBuffer::getMaxRangeValue() {
 }
  
 unsigned int BitBuffer::getMaxRangeValue(byte p_range) {
-  unsigned int ret;
+  unsigned int ret = 0;
   byte *p = (byte *)&ret;
   
   //for all values <255 byte representation represent integer value
@@ -616,15 +1504,18 @@ unsigned int BitBuffer::getMaxRangeValue(byte p_range) {
  * math.h does not define a logarithm to the base of two, http://stackoverflow.com/questions/758001/log2-not-found-in-my-math-h
  */
 unsigned int BitBuffer::getBitSize() {
-  if(s_bitSize < 1) {
-	  if(getMaxRangeValue() > 1)
-		  s_bitSize = round(log(getMaxRangeValue()) / M_LN2);
-	  else
-		  s_bitSize = 1;
-  }
+  if(s_bitSize < 1)
+	  s_bitSize = getBitSize(s_range);
   return s_bitSize;
 }
 
+unsigned int BitBuffer::getBitSize(byte p_range) {
+  if(getMaxRangeValue(p_range) > 1)
+	  return round(log(getMaxRangeValue(p_range)) / M_LN2);
+  
+  return 1;
+}
+
 // returns the size of the byte array for internal calculation
 unsigned int BitBuffer::getArraySize() {
   //size of the array is calculated by value range multiplied by requested number of values
@@ -632,138 +1523,835 @@ unsigned int BitBuffer::getArraySize() {
 }
 
 /*
- * Returns the value for the defined bitIndex
+ * Seqlock handling
+ * beginWrite/endWrite enclose all changes to the buffer, the sequence is odd in between.
+ * The memory barrier keeps the compiler from moving buffer accesses out of the enclosed section.
  */
-unsigned int BitBuffer::getValueInternal(unsigned long p_bitIndex) {
-	int offset;
-	byte mask;
-    byte *arrayValue = &s_data[((int) p_bitIndex / 8)];
-    offset = p_bitIndex % 8;
-    
-	//check if value can be retrieved from within the current array value
-    if(offset + getBitSize() <= 8)
-    {
-      mask = 0xFF << (8 - getBitSize());
-      mask = mask >> offset;
-	  
-	  #if BB_DEBUG_LEVEL > 2
-	  Serial.println("");
-	  Serial.print("GetValueInternal::mask: ");
-	  Serial.println(mask);
-	  Serial.print("GetValueInternal::Array value: ");
-	  Serial.println(*arrayValue);
-      #endif
-	  
-      byte v1 = *arrayValue & mask;
-	  v1 = v1 >> (8 - offset - getBitSize());
-	  
-	  return getIntegerValue(0x00, v1); 
-    }
-	//values that are distributed over current and next byte but not more
-    else if(offset + getBitSize() <= 16)
-    {
-      //value stored1/mask1: 00000011, value stored2/mask2: 11000000
-	  int overlength = offset + getBitSize() - 8;
-      mask = 0xFF << (8 - getBitSize() + overlength);
-      mask = mask >> offset;
-      byte valueHigh = *arrayValue & mask;
-      
-	  #if BB_DEBUG_LEVEL > 2
-	  Serial.print("GetValueInternal::mask: ");
-	  Serial.println(mask);
-	  Serial.print("GetValueInternal::Array value1: ");
-	  Serial.println(*arrayValue);
-	  #endif
+void BitBuffer::beginWrite() {
+  s_sequence++;
+  BB_MEMORY_BARRIER();
+  
+  //values in front may be removed or restamped, readers count expired values from the oldest one again
+  if(s_ttl != NULL)
+    s_ttl->expired = 0;
+}
+
+void BitBuffer::endWrite() {
+  BB_MEMORY_BARRIER();
+  s_sequence++;
+}
+
+/*
+ * Returns the sequence of the seqlock
+ * Reading the integer takes more than one instruction on 8 bit controllers, so it is read until two reads match.
+ */
+unsigned int BitBuffer::readSequence() {
+  unsigned int sequence;
+  
+  BB_MEMORY_BARRIER();
+  do
+  {
+    sequence = s_sequence;
+  } while(sequence != s_sequence);
+  BB_MEMORY_BARRIER();
+  
+  return sequence;
+}
+
+/*
+ * Maps the value to the defined range according to overflow state
+ * returns: false in case value is to be skipped
+ */
+boolean BitBuffer::mapToRange(unsigned int* p_value) {
+  return mapToRange(p_value, getMaxRangeValue(), s_overflow);
+}
+
+boolean BitBuffer::mapToRange(unsigned int* p_value, unsigned int p_maxValue, byte p_overflow) {
+  if(*p_value > p_maxValue)
+  {
+    if(p_overflow == OVERFLOW_MAX)
+      *p_value = p_maxValue;
+    else if(p_overflow == OVERFLOW_MIN)
+      *p_value = 0;
+    else
+      return false;
+  }
+  
+  return true;
+}
+
+/*
+ * Returns the bit index the next value will be written to
+ * as we have a defined size it might happen that there are still bits in the array left that will not be used
+ */
+unsigned long BitBuffer::getWriteBitIndex() {
+  if(s_bitIndex + getBitSize() > (unsigned long) getSize() * getBitSize())
+    return 0;
+  
+  return s_bitIndex;
+}
+
+/*
+ * Moves bitIndex behind the value written at getWriteBitIndex() and updates fill level
+ * the fill level does not grow if the oldest value was overwritten
+ */
+void BitBuffer::advanceBitIndex() {
+  //check if we reached end of capacity and overwrite old values
+  if(s_bitIndex + getBitSize() > (unsigned long) getSize() * getBitSize())
+  {
+	  s_bitIndex = 0;
+	  s_full = true;
+  }
+  
+  //once FIFO is full and nothing was popped the oldest value gets overwritten without changing the fill level
+  if(!s_full || s_popCount > 0)
+	  s_valueCount++;
+  
+  s_bitIndex = s_bitIndex + getBitSize();  
+  
+  //popped slots are only released again once the FIFO overran, before that bitIndex still grows with every push
+  if(s_full && s_popCount > 0) {
+	  s_popCount--;
 	  
-      mask = 0xFF << (8 - overlength);
-      arrayValue = &s_data[((int) p_bitIndex / 8 + 1)];
-      byte valueLow = *arrayValue & mask;
-
-	  #if BB_DEBUG_LEVEL > 2
-	  Serial.print("GetValueInternal::mask: ");
-	  Serial.println(mask);
-	  Serial.print("GetValueInternal::Array value2: ");
-	  Serial.println(*arrayValue);
+	  #if BB_DEBUG_LEVEL > 1
+	  Serial.print("AdvanceBitIndex::Decreased popCounter: ");
+	  Serial.println(s_popCount);
 	  #endif
-	  
-	  if(getMaxRangeValue() <= RANGE256)
-	  { 
-		  //valueHigh: 00000011, valueLow: 11000000, valueHigh': 00001100, valueLow': 00000011, valueHigh'&valueLow': 00001111
-		  valueHigh = valueHigh << overlength;
-		  valueLow = valueLow >> (8 - overlength);
-		  
-		  #if BB_DEBUG_LEVEL > 2
-		  Serial.print("GetValueInternal::Value1 shifted: ");
-		  Serial.println(valueHigh);
-		  Serial.print("GetValueInternal::Value2 shifted: ");
-		  Serial.println(valueLow);
-		  #endif
-		  
-		  return getIntegerValue(0x00, valueHigh | valueLow);
-	  }
-	  else //>255 and spread across 2 bytes
-	  {
-		  // value stored before: 00011111|11111100, return value: 00000111|11111111
-		  unsigned int valueIntShifted = getIntegerValue(valueHigh, valueLow);
-		  
-		  #if BB_DEBUG_LEVEL > 2
-		  Serial.print("GetValueInternal::Value before shift: ");
-		  Serial.println(valueIntShifted);
-		  #endif
-		  
-		  valueIntShifted = valueIntShifted >> (16 - (offset + getBitSize()));
-
-		  #if BB_DEBUG_LEVEL > 2
-		  Serial.print("GetValueInternal::Value1 shifted: ");
-		  Serial.println(((byte *) &valueIntShifted)[1]);
-		  Serial.print("GetValueInternal::Value2 shifted: ");
-		  Serial.println(((byte *) &valueIntShifted)[0]);
-		  #endif
-		  
-		  return valueIntShifted;
-	  }
-    }
-	//>255 and spread across 3 bytes
+  }
+} //END advanceBitIndex
+
+/*
+ * Calls watermark callback for every watermark the fill level crossed since the last check
+ * the fill level reached all watermarks from the rising watermark up to it or dropped below all watermarks from the falling
+ * watermark down to it. Watermarks are precomputed again before the callback is called, so it may push or pop itself.
+ */
+void BitBuffer::checkWatermarks() {
+  unsigned int rising = s_risingWatermark;
+  unsigned int falling = s_fallingWatermark;
+  
+  if((rising == 0 || s_valueCount < rising) && s_valueCount >= falling)
+	  return;
+  
+  updateWatermarks();
+  
+  if(rising != 0 && s_valueCount >= rising)
+  {
+	  if(s_lowWatermark >= rising && s_lowWatermark <= s_valueCount)
+		  s_watermarkCallback(this, WATERMARK_LOW);
+	  if(s_highWatermark >= rising && s_highWatermark <= s_valueCount)
+		  s_watermarkCallback(this, WATERMARK_HIGH);
+  }
+  else
+  {
+	  if(s_highWatermark <= falling && s_highWatermark > s_valueCount)
+		  s_watermarkCallback(this, WATERMARK_HIGH);
+	  if(s_lowWatermark <= falling && s_lowWatermark > s_valueCount)
+		  s_watermarkCallback(this, WATERMARK_LOW);
+  }
+} //END checkWatermarks
+
+/*
+ * Precomputes the watermarks the current fill level crosses next
+ * rising: lowest watermark above the fill level, falling: highest watermark at or below the fill level, 0 if none
+ */
+void BitBuffer::updateWatermarks() {
+  s_risingWatermark = 0;
+  s_fallingWatermark = 0;
+  
+  if(s_watermarkCallback == NULL)
+	  return;
+  
+  if(s_lowWatermark > s_valueCount)
+	  s_risingWatermark = s_lowWatermark;
+  else if(s_lowWatermark > 0)
+	  s_fallingWatermark = s_lowWatermark;
+  
+  if(s_highWatermark > s_valueCount && (s_risingWatermark == 0 || s_highWatermark < s_risingWatermark))
+	  s_risingWatermark = s_highWatermark;
+  else if(s_highWatermark > 0 && s_highWatermark <= s_valueCount && s_highWatermark > s_fallingWatermark)
+	  s_fallingWatermark = s_highWatermark;
+} //END updateWatermarks
+
+// returns the number of values stored in buffer including expired values not removed yet
+unsigned int BitBuffer::getStoredCount() {
+	return s_valueCount;
+}
+
+/*
+ * Maps the index in FIFO to the bit index of the value in the byte array
+ *
+ * p_index: index in FIFO starting with 1, needs to be validated by caller
+ */
+unsigned long BitBuffer::getBitIndex(unsigned p_index) {
+	return getNewestBitIndex(getStoredCount() - p_index + 1);
+} //END getBitIndex
+
+/*
+ * Maps the index counted from the newest value to the bit index of the value in the byte array
+ *
+ * p_index: index starting with 1 for the newest value, needs to be validated by caller
+ */
+unsigned long BitBuffer::getNewestBitIndex(unsigned p_index) {
+	unsigned long bitDelta = (unsigned long) p_index * getBitSize();
+	unsigned long bitIndex;
+	
+	// check if we have to take the value from the end of the buffer
+	if(bitDelta <= s_bitIndex)
+		bitIndex = s_bitIndex - bitDelta;
 	else
+		bitIndex = (unsigned long) getSize() * getBitSize() - bitDelta + s_bitIndex;
+	
+	#if BB_DEBUG_LEVEL > 1
+	Serial.print("GetNewestBitIndex::BitDelta: ");
+	Serial.println(bitDelta);
+	Serial.print("GetNewestBitIndex::Current BitIndex: ");
+	Serial.println(s_bitIndex);
+	Serial.print("GetNewestBitIndex::Value BitIndex: ");
+	Serial.println(bitIndex);
+	#endif
+	
+	return bitIndex;
+} //END getNewestBitIndex
+
+/*
+ * Writes the value to the defined bitIndex
+ */
+void BitBuffer::setValueInternal(unsigned long p_bitIndex, unsigned int p_value) {
+	#if BB_DEBUG_LEVEL > 1
+	Serial.print("SetValueInternal::Index for write: ");
+	Serial.println(p_bitIndex / 8);
+	#endif
+	
+	if(s_snapshots != NULL)
+		preserveBytes(p_bitIndex / 8, (p_bitIndex + getBitSize() - 1) / 8);
+	
+	//bits of neighbouring values in the first and last byte are kept by the writer
+	BitWriter writer(s_data, p_bitIndex, 0);
+	writer.write(p_value, getBitSize());
+	writer.flush();
+} //END setValueInternal(bitIndex, value)
+
+/*
+ * Hooks for features following the values in buffer, called within the write section for every value added to
+ * and removed from buffer, including the oldest value overwritten once the FIFO is full
+ */
+boolean BitBuffer::hasHooks() {
+	return s_histogram != NULL || s_archive != NULL;
+}
+
+void BitBuffer::valueAdded(unsigned int p_value) {
+	if(s_histogram != NULL)
+		updateHistogram(p_value, 1);
+}
+
+void BitBuffer::valueRemoved(unsigned int p_value, boolean p_evicted) {
+	if(s_histogram != NULL)
+		updateHistogram(p_value, -1);
+	if(s_archive != NULL && p_evicted)
+		archiveValue(p_value);
+}
+
+// returns whether p_buffer shares bits per value, size and write position with this buffer and both need no per value processing on push
+boolean BitBuffer::isLockstep(BitBuffer* p_buffer) {
+	return p_buffer->s_bitSize == s_bitSize && p_buffer->s_size == s_size && p_buffer->s_bitIndex == s_bitIndex
+		&& p_buffer->s_full == s_full && p_buffer->s_popCount == s_popCount
+		&& !hasHooks() && !p_buffer->hasHooks() && s_statistics == NULL && p_buffer->s_statistics == NULL
+		&& s_trigger == NULL && p_buffer->s_trigger == NULL && s_ttl == NULL && p_buffer->s_ttl == NULL
+		&& s_snapshots == NULL && p_buffer->s_snapshots == NULL
+		&& s_fullPolicy == FULL_OVERWRITE && p_buffer->s_fullPolicy == FULL_OVERWRITE;
+}
+
+/*
+ * Pushes the value to the write position given as byte index and shift of the value within the 24 bit window of 3 bytes
+ * starting at the byte index, bits of neighbouring values in the window are kept
+ * returns: whether value was stored
+ */
+boolean BitBuffer::pushLockstep(unsigned int p_value, unsigned long p_byteIndex, byte p_shift) {
+	if(!mapToRange(&p_value))
+		return false;
+	
+	uint32_t mask = ((1UL << getBitSize()) - 1) << p_shift;
+	uint32_t bits = (uint32_t) p_value << p_shift;
+	byte byteCount = (24 - p_shift + 7) / 8;
+	
+	beginWrite();
+	for(byte i = 0; i < byteCount; i++)
 	{
-		int overlength = offset + getBitSize() - 16;
-		unsigned long valueLongShifted = 0;
-		((byte *) &valueLongShifted)[2] = *arrayValue;
-		((byte *) &valueLongShifted)[1] = s_data[((int) p_bitIndex / 8 + 1)];
-		((byte *) &valueLongShifted)[0] = s_data[((int) p_bitIndex / 8 + 2)];
-		
-		#if BB_DEBUG_LEVEL > 2
-		Serial.print("GetValueInternal::Array value1: ");
-		Serial.println(*arrayValue);
-		Serial.print("GetValueInternal::Array value2: ");
-		Serial.println(s_data[((int) p_bitIndex / 8 + 1)]);
-		Serial.print("GetValueInternal::Array value3: ");
-		Serial.println(s_data[((int) p_bitIndex / 8 + 2)]);
-		Serial.print("GetValueInternal::Value before shift: ");
-		Serial.println(valueLongShifted);
-		#endif
+		byte byteMask = mask >> (16 - 8 * i);
+		s_data[p_byteIndex + i] = (s_data[p_byteIndex + i] & ~byteMask) | ((bits >> (16 - 8 * i)) & byteMask);
+	}
+	advanceBitIndex();
+	endWrite();
+	
+	if(s_valueCount == s_risingWatermark)
+		checkWatermarks();
+	
+	return true;
+} //END pushLockstep
+
+// changes the number of values p_value by p_delta in the histogram, updating all nodes covering p_value
+void BitBuffer::updateHistogram(unsigned int p_value, int p_delta) {
+	unsigned int nodeCount = getMaxRangeValue() + 1;
+	
+	for(unsigned int node = p_value + 1; node <= nodeCount; node += node & -node)
+		s_histogram[node - 1] += p_delta;
+}
+
+/*
+ * Updates streaming statistics by the value pushed
+ * Values are scaled to 16 bit, so the product of two differences fits into 32 bit. With weight a = 2^-shift:
+ * average += a * (value - average), variance = (1 - a) * (variance + (value - average) * a * (value - average))
+ */
+void BitBuffer::updateStatistics(unsigned int p_value) {
+	Statistics* statistics = s_statistics;
+	long value = (long) p_value << statistics->fraction;
+	
+	if(!statistics->initialized)
+	{
+		statistics->average = value;
+		statistics->variance = 0;
+		statistics->rate = 0;
+		statistics->lastValue = value;
+		statistics->initialized = true;
+		return;
+	}
+	
+	long difference = value - statistics->average;
+	long increment = difference / (1L << statistics->shift);
+	statistics->average += increment;
+	
+	//difference and increment have the same sign
+	unsigned long product = (unsigned long) labs(difference) * (unsigned long) labs(increment);
+	statistics->variance = (statistics->variance - (statistics->variance >> statistics->shift)) + (product - (product >> statistics->shift));
+	
+	statistics->rate += (value - statistics->lastValue - statistics->rate) / (1L << statistics->shift);
+	statistics->lastValue = value;
+} //END updateStatistics
+
+/*
+ * Checks the value to be pushed against the trigger
+ * the window trigger is a single compare, values below p_level wrap around to large differences
+ * returns: whether value may be stored, false if the capture is complete
+ */
+boolean BitBuffer::checkTrigger(unsigned int p_value) {
+	Trigger* trigger = s_trigger;
+	
+	if(trigger->state == TRIGGER_COMPLETE)
+		return false;
+	
+	if(trigger->state == TRIGGER_FIRED)
+	{
+		trigger->captured++;
+		return true;
+	}
+	
+	if(trigger->state == TRIGGER_ARMED && getStoredCount() >= trigger->preCount)
+	{
+		boolean fired;
 		
-		valueLongShifted = valueLongShifted << 8 + offset;
-		valueLongShifted = valueLongShifted >> 8 + offset + (8 - overlength);
+		if(trigger->mode == TRIGGER_RISING)
+			fired = trigger->hasLastValue && trigger->lastValue < trigger->level && p_value >= trigger->level;
+		else if(trigger->mode == TRIGGER_FALLING)
+			fired = trigger->hasLastValue && trigger->lastValue > trigger->level && p_value <= trigger->level;
+		else
+			fired = p_value - trigger->level > trigger->upper - trigger->level;
 		
-		#if BB_DEBUG_LEVEL > 2
-		Serial.print("GetValueInternal::Value1 shifted: ");
-		Serial.println(((byte *) &valueLongShifted)[1]);
-		Serial.print("GetValueInternal::Value2 shifted: ");
-		Serial.println(((byte *) &valueLongShifted)[0]);
-		#endif
+		if(fired)
+		{
+			trigger->state = TRIGGER_FIRED;
+			trigger->captured = 0;
+			
+			#if BB_DEBUG_LEVEL > 1
+			Serial.print("CheckTrigger::Fired at value: ");
+			Serial.println(p_value);
+			#endif
+		}
+	}
+	
+	trigger->lastValue = p_value;
+	trigger->hasLastValue = true;
+	return true;
+} //END checkTrigger
+
+/*
+ * Adds the value leaving the buffer to the block of the archive, the reduced block is pushed into the archive once complete
+ * the archive pushes its own evicted values into its archive, so buffers can be cascaded
+ */
+void BitBuffer::archiveValue(unsigned int p_value) {
+	Archive* archive = s_archive;
+	
+	if(archive->count == 0)
+		archive->accumulator = p_value;
+	else if(archive->function == ARCHIVE_MIN)
+		archive->accumulator = p_value < archive->accumulator ? p_value : archive->accumulator;
+	else if(archive->function == ARCHIVE_MAX)
+		archive->accumulator = p_value > archive->accumulator ? p_value : archive->accumulator;
+	else
+		archive->accumulator += p_value;
+	
+	if(++archive->count < archive->blockSize)
+		return;
+	
+	unsigned long value = archive->accumulator;
+	if(archive->function == ARCHIVE_AVERAGE)
+		value = (value + archive->blockSize / 2) / archive->blockSize;
+	
+	if(archive->shift > 0)
+		value <<= archive->shift;
+	else
+		value >>= -archive->shift;
+	
+	archive->count = 0;
+	archive->buffer->push(value);
+} //END archiveValue
+
+/*
+ * Applies the full policy to the value pushed
+ * FULL_RESERVOIR: reservoir sampling (algorithm R), once full the n-th value replaces a random value with probability getSize() / n
+ * FULL_DECIMATE: only every getDecimation()-th value is accepted, once full the values are decimated 2:1 and the rate halves
+ *                by the first value accepted at the halved rate
+ *
+ * p_stored: receives whether value was stored if it is not to be appended
+ * returns: whether value is to be appended by push
+ */
+boolean BitBuffer::sampleValue(unsigned int p_value, boolean* p_stored) {
+	unsigned long seen = s_seenCount++;
+	*p_stored = false;
+	
+	if(s_fullPolicy == FULL_DECIMATE)
+	{
+		if(seen % s_decimation != 0)
+			return false;
+		
+		if(getStoredCount() < getSize())
+			return true;
+		
+		//decimation halves the rate, so the buffer is only decimated by a value accepted at the new one
+		if(seen % (2UL * s_decimation) != 0)
+			return false;
 		
-		return ((unsigned int) valueLongShifted);
+		decimate();
+		return true;
 	}
-} //END getValueInternal(bitIndex)
+	
+	if(getStoredCount() < getSize())
+		return true;
+	
+	unsigned long slot = random(seen + 1);
+	if(slot >= getSize())
+		return false;
+	
+	unsigned long bitIndex = getBitIndex(slot + 1);
+	
+	beginWrite();
+	if(hasHooks())
+	{
+		valueRemoved(getValueInternal(bitIndex), true);
+		valueAdded(p_value);
+	}
+	setValueInternal(bitIndex, p_value);
+	if(s_ttl != NULL)
+		s_ttl->stamps[getStampPosition(getSize() - slot) / s_ttl->blockSize] = millis();
+	
+	//value is replaced in place, readers have to read again as if the buffer was overwritten completely
+	s_sequence += 2 * getSize();
+	endWrite();
+	
+	*p_stored = true;
+	return false;
+} //END sampleValue
 
-//performs a transformation of two byte into an integer
-unsigned int BitBuffer::getIntegerValue(byte highByte, byte lowByte) {
-	int ret;
-    byte *p = (byte *)&ret;
+/*
+ * Removes every second value in place, keeping the oldest value and every second one after it
+ * Values are streamed from the oldest one in ring direction, the writer follows the reader, so each byte is read before it is written.
+ * Afterwards the buffer is in the representation of a full FIFO with the freed slots counted as popped.
+ */
+void BitBuffer::decimate() {
+	unsigned int count = getStoredCount();
+	unsigned long ringSize = (unsigned long) getSize() * getBitSize();
+	unsigned long bitIndex = getBitIndex(1);
+	unsigned int kept = 0;
 	
-	p[1] = highByte;
-	p[0] = lowByte;
+	if(s_snapshots != NULL)
+		preserveBytes(0, getArraySize() - 1);
 	
-	return ret;
+	BitReader reader(s_data, bitIndex, ringSize);
+	BitWriter writer(s_data, bitIndex, ringSize);
+	
+	beginWrite();
+	
+	for(unsigned int i = 0; i < count; i++)
+	{
+		unsigned int value = reader.read(getBitSize());
+		
+		if(i % 2 == 0)
+		{
+			//the value moves to the position of the kept ones, its block takes the timestamp of the block it came from
+			if(s_ttl != NULL)
+				s_ttl->stamps[getStampPosition(count - kept) / s_ttl->blockSize] = s_ttl->stamps[getStampPosition(count - i) / s_ttl->blockSize];
+			
+			writer.write(value, getBitSize());
+			kept++;
+		}
+		else if(hasHooks())
+			valueRemoved(value, true);
+	}
+	
+	writer.flush();
+	
+	if(s_ttl != NULL)
+		s_ttl->position = getStampPosition(count - kept);
+	
+	s_bitIndex = writer.getBitIndex();
+	s_full = true;
+	s_popCount = getSize() - kept;
+	s_valueCount = kept;
+	s_decimation *= 2;
+	
+	//all values moved, readers have to read again as if the buffer was overwritten completely
+	s_sequence += 2 * getSize();
+	endWrite();
+	
+	if(s_valueCount < s_fallingWatermark)
+		checkWatermarks();
+	
+	#if BB_DEBUG_LEVEL > 1
+	Serial.print("Decimate::Values per value stored: ");
+	Serial.println(s_decimation);
+	#endif
+} //END decimate
+
+// sets the timestamp of the block of the value appended and moves the position for the next one
+void BitBuffer::stampValue() {
+	s_ttl->stamps[s_ttl->position / s_ttl->blockSize] = millis();
+	
+	s_ttl->position++;
+	if(s_ttl->position >= (unsigned long) s_ttl->blockCount * s_ttl->blockSize)
+		s_ttl->position = 0;
+}
+
+/*
+ * Maps the index counted from the newest value to the position of the value in the blocks of timestamps,
+ * the timestamp of the value is stamps[position / blockSize]
+ *
+ * p_index: index starting with 1 for the newest value, 0 for the next value appended
+ */
+unsigned long BitBuffer::getStampPosition(unsigned p_index) {
+	if(p_index <= s_ttl->position)
+		return s_ttl->position - p_index;
+	
+	return (unsigned long) s_ttl->blockCount * s_ttl->blockSize - p_index + s_ttl->position;
+}
+
+/*
+ * Returns the number of expired values starting with the oldest one, the buffer is not changed
+ * All values of a block are older than its timestamp, so once the timestamp expired the values from the oldest one up to
+ * the end of the block expired. Blocks are checked from the first one not known to be expired up to the first one not expired,
+ * the values found are remembered for the next call until a writer changes the buffer, so each block is checked once per write.
+ */
+unsigned int BitBuffer::getExpiredCount() {
+	unsigned int sequence;
+	unsigned int expiredCount;
+	
+	BB_ATOMIC_BLOCK
+	{
+		sequence = s_sequence;
+		expiredCount = s_ttl->expired;
+	}
+	
+	unsigned long now = millis();
+	unsigned int count = getStoredCount();
+	
+	while(expiredCount < count)
+	{
+		unsigned long position = getStampPosition(count - expiredCount);
+		
+		if(now - s_ttl->stamps[position / s_ttl->blockSize] <= s_ttl->ttl)
+			break;
+		
+		//values up to the end of the block
+		expiredCount += s_ttl->blockSize - position % s_ttl->blockSize;
+	}
+	
+	if(expiredCount > count)
+		expiredCount = count;
+	
+	//only remembered if no writer changed the buffer meanwhile or was interrupted by this call
+	BB_ATOMIC_BLOCK
+	{
+		if(s_sequence == sequence && sequence % 2 == 0)
+			s_ttl->expired = expiredCount;
+	}
+	
+	return expiredCount;
+} //END getExpiredCount
+
+/*
+ * Removes expired values starting with the oldest one
+ * Called by the methods writing to or consuming from buffer only, readers skip expired values without removing them.
+ */
+void BitBuffer::expireValues() {
+	unsigned int count = getExpiredCount();
+	if(count == 0)
+		return;
+	
+	beginWrite();
+	if(hasHooks())
+	{
+		BitReader reader(s_data, getBitIndex(1), (unsigned long) getSize() * getBitSize());
+		for(unsigned int i = 0; i < count; i++)
+			valueRemoved(reader.read(getBitSize()), true);
+	}
+	s_popCount += count;
+	s_valueCount -= count;
+	endWrite();
+	
+	if(s_valueCount < s_fallingWatermark)
+		checkWatermarks();
+	
+	#if BB_DEBUG_LEVEL > 1
+	Serial.print("ExpireValues::Expired values: ");
+	Serial.println(count);
+	#endif
+} //END expireValues
+
+// completes the capture once all values after the trigger were stored and calls the callback
+void BitBuffer::completeTrigger() {
+	if(s_trigger->state != TRIGGER_FIRED || s_trigger->captured < s_trigger->postCount)
+		return;
+	
+	s_trigger->state = TRIGGER_COMPLETE;
+	
+	if(s_trigger->callback != NULL)
+		s_trigger->callback(this);
+}
+
+/*
+ * Returns the number of values that may be stored without overwriting values in front of the trigger
+ * while armed the trigger might fire at the first value, so at most the trigger and the values after it fit
+ */
+unsigned int BitBuffer::getTriggerCapacity() {
+	if(s_trigger->state == TRIGGER_COMPLETE)
+		return 0;
+	if(s_trigger->state == TRIGGER_FIRED)
+		return s_trigger->postCount - s_trigger->captured;
+	if(s_trigger->state == TRIGGER_ARMED)
+		return s_trigger->postCount + 1;
+	
+	return getSize();
+}
+
+// copies the pages containing the defined bytes into all snapshots before they get overwritten
+void BitBuffer::preserveBytes(unsigned int p_firstByte, unsigned int p_lastByte) {
+	for(BitBufferSnapshot* snapshot = s_snapshots; snapshot != NULL; snapshot = snapshot->s_next)
+		snapshot->preserve(p_firstByte, p_lastByte);
+}
+
+/*
+ * Returns the bit ranges of the values in buffer in FIFO order
+ * values start at the oldest one and wrap at the end of the used bits of the array, so there are up to two ranges
+ * returns: number of ranges
+ */
+byte BitBuffer::getWindow(unsigned long* p_bitIndex, unsigned long* p_bitCount) {
+	unsigned int count = getValueCount();
+	unsigned long bitCount = (unsigned long) count * getBitSize();
+	if(bitCount == 0)
+		return 0;
+	
+	//counted from the newest value, so expired values in front are skipped
+	unsigned long ringSize = (unsigned long) getSize() * getBitSize();
+	p_bitIndex[0] = getNewestBitIndex(count);
+	
+	if(p_bitIndex[0] + bitCount <= ringSize)
+	{
+		p_bitCount[0] = bitCount;
+		return 1;
+	}
+	
+	p_bitCount[0] = ringSize - p_bitIndex[0];
+	p_bitIndex[1] = 0;
+	p_bitCount[1] = bitCount - p_bitCount[0];
+	return 2;
+} //END getWindow
+
+/*
+ * Returns 32 bit of the array starting at p_wordIndex, a multiple of 32
+ * values are stored MSB first, so loading bytes in order keeps the first value in the most significant bits
+ */
+uint32_t BitBuffer::getWord(unsigned long p_wordIndex) {
+	uint32_t word = 0;
+	
+	for(byte i = 0; i < 4; i++)
+	{
+		word <<= 8;
+		if(p_wordIndex / 8 + i < getArraySize())
+			word |= s_data[p_wordIndex / 8 + i];
+	}
+	
+	return word;
+}
+
+/*
+ * Single pass over all values in buffer computing the requested aggregates, pointers of aggregates not needed are NULL
+ * For value sizes dividing 32 bit the values of a word are reduced lane-wise (SWAR): the sum by adding neighbouring lanes
+ * with doubling width, minimum and maximum by keeping the smaller / larger value of every lane across words. Lanes outside
+ * of the values in buffer are set to a neutral value beforehand. Other value sizes are decoded value by value.
+ */
+void BitBuffer::aggregate(unsigned long* p_sum, unsigned int* p_min, unsigned int* p_max, unsigned int* p_counts, unsigned int p_binCount) {
+	unsigned long bitIndex[2];
+	unsigned long bitCount[2];
+	byte windowCount = getWindow(bitIndex, bitCount);
+	unsigned long sum = 0;
+	unsigned int minValue = getMaxRangeValue();
+	unsigned int maxValue = 0;
+	
+	if(p_counts != NULL)
+		memset(p_counts, 0, p_binCount * sizeof(unsigned int));
+	
+	if(32 % getBitSize() != 0)
+	{
+		BitReader reader(s_data, 0, 0);
+		
+		for(byte window = 0; window < windowCount; window++)
+		{
+			reader.seek(bitIndex[window]);
+			
+			for(unsigned long i = bitCount[window] / getBitSize(); i > 0; i--)
+			{
+				unsigned int value = reader.read(getBitSize());
+				
+				sum += value;
+				if(value < minValue)
+					minValue = value;
+				if(value > maxValue)
+					maxValue = value;
+				if(p_counts != NULL)
+					p_counts[(unsigned long) value * p_binCount / ((unsigned long) getMaxRangeValue() + 1)]++;
+			}
+		}
+	}
+	else
+	{
+		uint32_t laneMask = (1UL << getBitSize()) - 1;
+		uint32_t highBits = 0xFFFFFFFFUL / laneMask << (getBitSize() - 1);
+		uint32_t minLanes = 0xFFFFFFFFUL;
+		uint32_t maxLanes = 0;
+		
+		for(byte window = 0; window < windowCount; window++)
+		{
+			unsigned long end = bitIndex[window] + bitCount[window];
+			
+			for(unsigned long wordIndex = bitIndex[window] & ~31UL; wordIndex < end; wordIndex += 32)
+			{
+				uint32_t word = getWord(wordIndex);
+				
+				byte first = wordIndex < bitIndex[window] ? bitIndex[window] - wordIndex : 0;
+				byte last = end - wordIndex < 32 ? end - wordIndex : 32;
+				uint32_t valid = 0xFFFFFFFFUL >> first;
+				if(last < 32)
+					valid &= ~(0xFFFFFFFFUL >> last);
+				
+				if(p_sum != NULL)
+					sum += sumLanes(word & valid);
+				
+				//spreading the flag of the most significant bit to the whole lane selects the value of the lanes compared
+				uint32_t select = (lessLanes(maxLanes, word & valid, highBits) >> (getBitSize() - 1)) * laneMask;
+				maxLanes = (maxLanes & ~select) | (word & valid & select);
+				select = (lessLanes(word | ~valid, minLanes, highBits) >> (getBitSize() - 1)) * laneMask;
+				minLanes = (minLanes & ~select) | ((word | ~valid) & select);
+				
+				if(p_counts != NULL)
+				{
+					for(byte bit = first; bit < last; bit += getBitSize())
+					{
+						unsigned int value = (word >> (32 - bit - getBitSize())) & laneMask;
+						p_counts[(unsigned long) value * p_binCount / (laneMask + 1)]++;
+					}
+				}
+			}
+		}
+		
+		for(byte bit = 0; bit < 32; bit += getBitSize())
+		{
+			unsigned int value = (minLanes >> bit) & laneMask;
+			if(value < minValue)
+				minValue = value;
+			value = (maxLanes >> bit) & laneMask;
+			if(value > maxValue)
+				maxValue = value;
+		}
+	}
+	
+	if(windowCount == 0)
+		minValue = 0;
+	
+	if(p_sum != NULL)
+		*p_sum = sum;
+	if(p_min != NULL)
+		*p_min = minValue;
+	if(p_max != NULL)
+		*p_max = maxValue;
+} //END aggregate
+
+/*
+ * Returns the sum of all lanes of the word
+ * neighbouring lanes are added into lanes of double width until a single lane is left, no lane can overflow
+ */
+uint32_t BitBuffer::sumLanes(uint32_t p_word) {
+	for(byte shift = getBitSize(); shift < 32; shift <<= 1)
+	{
+		uint32_t mask = shift == 16 ? 0x0000FFFFUL : 0xFFFFFFFFUL / ((1UL << (2 * shift)) - 1) * ((1UL << shift) - 1);
+		p_word = (p_word & mask) + ((p_word >> shift) & mask);
+	}
+	
+	return p_word;
+}
+
+/*
+ * Lane-wise comparison of 32 bit words holding 32 / getBitSize() values
+ * Setting the most significant bit of each value of p_a and clearing it in p_b, the subtraction compares the lower bits
+ * of all values at once without borrowing from the neighbouring value: the most significant bit stays set where the
+ * lower bits of p_a are not less than those of p_b. Combined with the most significant bits this results in p_a < p_b.
+ */
+uint32_t BitBuffer::lessLanes(uint32_t p_a, uint32_t p_b, uint32_t p_highBits) {
+	uint32_t difference = (p_a | p_highBits) - (p_b & ~p_highBits);
+	return ((~p_a & p_b) | (~(p_a ^ p_b) & ~difference)) & p_highBits;
+}
+
+// equal values have all bits of the lane set after xor and negation, folding them with and ends up in the most significant bit
+uint32_t BitBuffer::equalLanes(uint32_t p_a, uint32_t p_b, uint32_t p_highBits) {
+	uint32_t equal = ~(p_a ^ p_b);
+	
+	for(byte shift = 1; shift < getBitSize(); shift <<= 1)
+		equal &= equal << shift;
+	
+	return equal & p_highBits;
 }
+
+// returns the most significant bit of each value set where the value matches the scan operator
+uint32_t BitBuffer::matchLanes(uint32_t p_word, byte p_operator, uint32_t p_value, uint32_t p_upper, uint32_t p_highBits) {
+	if(p_operator == SCAN_EQUAL)
+		return equalLanes(p_word, p_value, p_highBits);
+	if(p_operator == SCAN_NOT_EQUAL)
+		return ~equalLanes(p_word, p_value, p_highBits) & p_highBits;
+	if(p_operator == SCAN_LESS)
+		return lessLanes(p_word, p_value, p_highBits);
+	
+	//between: neither below the lower bound nor above the upper bound
+	return ~(lessLanes(p_word, p_value, p_highBits) | lessLanes(p_upper, p_word, p_highBits)) & p_highBits;
+}
+
+/*
+ * Returns the value for the defined bitIndex
+ */
+unsigned int BitBuffer::getValueInternal(unsigned long p_bitIndex) {
+	BitReader reader(s_data, p_bitIndex, 0);
+	unsigned int ret = reader.read(getBitSize());
+	
+	#if BB_DEBUG_LEVEL > 2
+	Serial.print("GetValueInternal::Value: ");
+	Serial.println(ret);
+	#endif
+	
+	return ret;
+} //END getValueInternal(bitIndex)
@@ -1,3 +1,6 @@
+#ifndef BitBuffer_h
+#define BitBuffer_h
+
 /*
  *	DEBUGGING
  *  for debugging purpose define BB_DEBUG_LEVEL with one of the below values, all debug information will be sent to Serial
@@ -8,6 +11,20 @@
  */
 #define BB_DEBUG_LEVEL 0
 
+/*
+ *	ATOMIC SECTIONS
+ *  read-modify-write operations (updateValue, ...) enclose their work with BB_ATOMIC_BLOCK { ... }, which disables
+ *  interrupts meanwhile, so interrupt routines writing to the same instance cannot interfere. On AVR the previous state is
+ *  restored afterwards, other platforms use noInterrupts() and interrupts() and thus enable interrupts when leaving the block.
+ *  The block must not be left by return or break.
+ */
+#if defined(__AVR__)
+#include <util/atomic.h>
+#define BB_ATOMIC_BLOCK ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+#else
+#define BB_ATOMIC_BLOCK for(byte bb_atomic = (noInterrupts(), 1); bb_atomic; interrupts(), bb_atomic = 0)
+#endif
+
 
 #if defined(ARDUINO) && ARDUINO >= 100
 #include "Arduino.h"
@@ -15,6 +32,10 @@
 #include "WProgram.h"
 #endif
 
+#include "BitStream.h"
+
+class BitBufferSnapshot;
+
 class BitBuffer
 {
 	public:
@@ -40,6 +61,59 @@ class BitBuffer
 		static const byte OVERFLOW_MAX;
 		static const byte OVERFLOW_MIN;
 		static const byte OVERFLOW_SKIP;
+		
+		// static constants for watermark passed to watermark callback
+		static const byte WATERMARK_LOW;
+		static const byte WATERMARK_HIGH;
+		
+		// static constants for scan operators
+		static const byte SCAN_EQUAL;
+		static const byte SCAN_NOT_EQUAL;
+		static const byte SCAN_LESS;
+		static const byte SCAN_BETWEEN;
+		
+		// static constants for trigger mode
+		static const byte TRIGGER_RISING;
+		static const byte TRIGGER_FALLING;
+		static const byte TRIGGER_WINDOW;
+		
+		// static constants for trigger state
+		static const byte TRIGGER_ARMED;
+		static const byte TRIGGER_FIRED;
+		static const byte TRIGGER_COMPLETE;
+		
+		// static constants for archive reduction
+		static const byte ARCHIVE_MIN;
+		static const byte ARCHIVE_MAX;
+		static const byte ARCHIVE_AVERAGE;
+		
+		// static constants for full policy
+		static const byte FULL_OVERWRITE;
+		static const byte FULL_RESERVOIR;
+		static const byte FULL_DECIMATE;
+	
+	
+		// ##### STATIC METHODS #####
+		/*
+		 * Range handling shared with other containers storing values of a defined range (BitQueue, ...)
+		 * getMaxRangeValue - returns the maximum value that can be stored for the range
+		 * getBitSize - returns the number of bits required per value for the range
+		 * mapToRange - maps the value to p_maxValue according to overflow state, returns false if value is to be skipped
+		 */
+		static unsigned int getMaxRangeValue(byte p_range);
+		static unsigned int getBitSize(byte p_range);
+		static boolean mapToRange(unsigned int* p_value, unsigned int p_maxValue, byte p_overflow);
+		
+		/*
+		 * Pushes one frame of values into p_count buffers, p_values[i] into p_buffers[i], e.g. one sample per channel and tick.
+		 * Buffers of the same bits per value and size that were filled in lockstep share their write position, which is then computed
+		 * once for the whole frame and each value is written directly to the same bytes of its buffer. Buffers not in lockstep
+		 * or using hooks, statistics, triggers, TTL, snapshots or another full policy than FULL_OVERWRITE are pushed one by one.
+		 * Values are mapped according to the overflow state of their buffer, a skipped value leaves its buffer out of lockstep.
+		 *
+		 * returns: number of values stored
+		 */
+		static unsigned int push(BitBuffer** p_buffers, const unsigned int* p_values, unsigned int p_count);
 	
 	
 		// ##### static constRUCTOR #####
@@ -48,6 +122,7 @@ class BitBuffer
 		// ##### METHODS #####
 		/*
 		 * Resets buffer instance and frees memory
+		 * Snapshots of the buffer copy all values they still reference beforehand and stay valid.
 		 */
 		void flush();
 		
@@ -64,9 +139,21 @@ class BitBuffer
 		// returns capacity of values that can be stored in buffer for defined range
 		unsigned int getSize();
 		
-		// returns the number of values currently stored in buffer
+		// returns the number of values currently stored in buffer, expired values are not counted
 		unsigned int getValueCount();
 		
+		/*
+		 * Watermark handling
+		 * Defines fill levels (number of values in buffer) on which p_callback is called once the fill level
+		 * crosses them, e.g. waking up a consumer at 75% and raising an alert at 95% of getSize(). A watermark is crossed
+		 * by reaching it while values are added (push, commit, ...) and by dropping below it while values are removed
+		 * (pop, expiry, ...), getValueCount() tells the direction. Overwriting the oldest value does not change the fill
+		 * level and will not call p_callback again. The next watermarks to cross are precomputed, so push compares the
+		 * fill level once. A watermark of 0 is disabled, passing NULL as p_callback disables watermark handling.
+		 * p_callback receives the buffer and WATERMARK_LOW or WATERMARK_HIGH.
+		 */
+		void setWatermarks(unsigned int p_low, unsigned int p_high, void (*p_callback)(BitBuffer*, byte));
+		
 		/*
 		 * central methods for buffer to fill and retrieve values.
 		 * buffer will act like a FIFO, replacing old values once capacity of buffer was reached. calling
@@ -79,6 +166,32 @@ class BitBuffer
 		boolean push(unsigned int p_value);
 		unsigned int pop();
 		
+		/*
+		 * Bulk push of p_count values in one go, e.g. a block of samples read at once.
+		 * Values are written like reserve/write/commit, values to be skipped according to overflow state are left out
+		 * and do not remove stored values.
+		 *
+		 * returns: number of values stored
+		 */
+		unsigned int push(const unsigned int* p_values, unsigned int p_count);
+		
+		/*
+		 * Double-ended access in addition to FIFO push/pop, e.g. for undoing the last values or displaying latest values first.
+		 * pop_back removes the newest value, push_front adds a value in front of the oldest one as long as buffer is not full.
+		 * The FIFO index of all other values is not changed by pop_back, but increased by one by push_front.
+		 *
+		 * returns: newest value in buffer / whether value was stored, false if it was skipped or buffer is full
+		 */
+		unsigned int pop_back();
+		boolean push_front(unsigned int p_value);
+		
+		/*
+		 * Returns the specified index in the buffer counted from the newest value without deleting it.
+		 *
+		 * p_index: index starting with 1 for the newest value
+		 */
+		unsigned int getNewest(unsigned p_index);
+		
 		/*
 		 * Returns the specified index in the buffer without deleting it.
 		 * The index does not correspond with the internal bit-Index nor the array-Index but represents the
@@ -90,6 +203,178 @@ class BitBuffer
 		 */
 		unsigned int getValue(unsigned p_index);
 		
+		/*
+		 * Rewrites the value at the specified index in FIFO in place, e.g. to correct a sample after it was pushed.
+		 * The value is mapped to the defined range according to overflow state like on push.
+		 * updateValue is an atomic read-modify-write, p_function is called with the current value and returns the new one.
+		 *
+		 * p_index: index in FIFO starting with 1
+		 * returns: whether value was stored / value before update or 0 in case of invalid index
+		 */
+		boolean setValue(unsigned int p_index, unsigned int p_value);
+		unsigned int updateValue(unsigned int p_index, unsigned int (*p_function)(unsigned int));
+		
+		/*
+		 * Consistent retrieval of p_count values starting at the specified index in FIFO without deleting them.
+		 * Buffer supports a single writer (push, write, commit, pop) and multiple readers (getValue, getValues),
+		 * e.g. an interrupt routine sampling values while loop() displays them. Readers take an optimistic
+		 * snapshot of the buffer state and only read again if the writer wrapped over the values read meanwhile
+		 * or rewrote values in place (setValue, updateValue, ...).
+		 *
+		 * p_index: index in FIFO starting with 1
+		 * returns: number of values written to p_values
+		 */
+		unsigned int getValues(unsigned p_index, unsigned int* p_values, unsigned int p_count);
+		
+		/*
+		 * Batch retrieval for consumers draining the buffer in one go instead of calling pop for every value.
+		 * Up to p_count values are copied in FIFO order into p_values and removed from the buffer.
+		 *
+		 * returns: number of values written to p_values
+		 */
+		unsigned int pop(unsigned int* p_values, unsigned int p_count);
+		
+		/*
+		 * Readiness based batch retrieval, removes exactly p_count values or none while less are in buffer.
+		 * Together with a watermark at p_count values a consumer is woken once per batch by the watermark callback
+		 * and takes the whole batch at once instead of polling getValueCount() or being woken per value.
+		 *
+		 * returns: p_count if values were written to p_values and removed from buffer, 0 otherwise
+		 */
+		unsigned int popIfAvailable(unsigned int* p_values, unsigned int p_count);
+		
+		/*
+		 * Predicate scan over all values in buffer without retrieving them one by one, e.g. finding samples above a threshold.
+		 * SCAN_EQUAL / SCAN_NOT_EQUAL - value equal / not equal to p_value
+		 * SCAN_LESS - value less than p_value
+		 * SCAN_BETWEEN - value between p_value and p_upper, both included
+		 * For 1, 2, 4 and 8 bit values all values of a 32 bit word are compared at once.
+		 *
+		 * p_bitmap: optional array of (getValueCount() + 7) / 8 bytes receiving one bit per value in FIFO order,
+		 *           the first value in the most significant bit of the first byte like the values in buffer
+		 * returns: number of values matching
+		 */
+		unsigned int scan(byte p_operator, unsigned int p_value, unsigned int p_upper = 0, byte* p_bitmap = NULL);
+		
+		/*
+		 * Aggregates over all values in buffer without retrieving them, e.g. for displaying statistics of the values in buffer.
+		 * getMin and getMax return 0 for an empty buffer. For 1, 2, 4 and 8 bit values the values of a 32 bit word are reduced at once.
+		 *
+		 * p_counts: array of p_binCount counters receiving the number of values per bin for getHistogram, the range of values
+		 *           is split into p_binCount bins of equal size, e.g. getMaxRangeValue() + 1 bins count every value separately
+		 */
+		unsigned long getSum();
+		unsigned int getMin();
+		unsigned int getMax();
+		void getHistogram(unsigned int* p_counts, unsigned int p_binCount);
+		
+		/*
+		 * Incrementally maintained histogram for ranges up to RANGE256, e.g. for the median or 99th percentile of the values in buffer.
+		 * Once enabled every value pushed, committed, popped or overwritten updates the histogram in O(log range) and getQuantile
+		 * takes O(log range) instead of sorting the values. rebuildHistogram counts all values again.
+		 *
+		 * p_percent: percentage of values less or equal than the returned value, e.g. 50 for the median
+		 * returns: whether histogram could be enabled / quantile or 0 if buffer is empty or histogram is not enabled
+		 */
+		boolean enableHistogram();
+		void disableHistogram();
+		void rebuildHistogram();
+		unsigned int getQuantile(byte p_percent);
+		
+		/*
+		 * Streaming statistics of all values pushed, updated on push and commit without reading values from buffer again.
+		 * Each value pushed is weighted by 2^-p_shift against the history (exponential decay), e.g. p_shift 4 weights the
+		 * latest value by 1/16. Statistics are calculated in fixed point, so they cost no floating point operations on push.
+		 * getAverage - exponentially weighted moving average (EWMA)
+		 * getVariance - exponentially decayed variance around the average
+		 * getRate - exponentially weighted average of the change between consecutive values
+		 *
+		 * returns: whether statistics could be enabled, false if memory is exhausted / statistic or 0 if not enabled
+		 */
+		boolean enableStatistics(byte p_shift);
+		void disableStatistics();
+		float getAverage();
+		float getVariance();
+		float getRate();
+		
+		/*
+		 * Trigger handling for capturing values around an event like an oscilloscope, without copying or scanning values.
+		 * Once armed, every value pushed is checked against the trigger:
+		 * TRIGGER_RISING / TRIGGER_FALLING - value reaches p_level from below / from above
+		 * TRIGGER_WINDOW - value leaves the window from p_level to p_upper
+		 * The trigger fires once at least p_preCount values are in buffer, afterwards p_postCount values are pushed before
+		 * the capture is complete and p_callback is called. Complete captures are kept: push returns false until armed again,
+		 * so values in front of the trigger are never overwritten. Values written by reserve/write are checked on commit,
+		 * values not appended by the full policy are not checked.
+		 *
+		 * returns: whether trigger could be set, false if memory is exhausted / whether trigger could be armed, false if
+		 *          no trigger is set or p_preCount, trigger and p_postCount exceed getSize() / current state or 0 if not set /
+		 *          index in FIFO of the value that fired the trigger or 0 if it did not fire
+		 */
+		boolean setTrigger(byte p_mode, unsigned int p_level, unsigned int p_upper, void (*p_callback)(BitBuffer*));
+		void disableTrigger();
+		boolean armTrigger(unsigned int p_preCount, unsigned int p_postCount);
+		byte getTriggerState();
+		unsigned int getTriggerIndex();
+		
+		/*
+		 * Archive handling for keeping a long history at a coarser resolution in constant memory (round-robin archive).
+		 * Values leaving the buffer, popped or overwritten once the FIFO is full, are reduced in blocks of p_blockSize
+		 * values by ARCHIVE_MIN, ARCHIVE_MAX or ARCHIVE_AVERAGE and pushed into p_archive. The archive may have a different
+		 * range, values are scaled by the difference in bits. Archives can have archives themselves, e.g. values per second
+		 * archived as averages per minute archived as averages per hour. Passing NULL as p_archive disables the archive.
+		 * getArchive returns the finest buffer of the cascade which together with all finer buffers covers p_span values
+		 * pushed into this buffer, p_resolution receives the number of values pushed per value of the buffer returned.
+		 *
+		 * returns: whether archive could be set, false if memory is exhausted or p_archive is this buffer or archives into it / buffer covering p_span
+		 */
+		boolean setArchive(BitBuffer* p_archive, unsigned int p_blockSize, byte p_function);
+		BitBuffer* getArchive(unsigned long p_span, unsigned long* p_resolution = NULL);
+		
+		/*
+		 * Full policy
+		 * Defines what happens to values pushed once the buffer is full, so a fixed size covers an unbounded stream.
+		 * FULL_OVERWRITE - the oldest value is overwritten (default)
+		 * FULL_RESERVOIR - the buffer keeps a uniform random sample of all values pushed (reservoir sampling),
+		 *                  push returns false for values not sampled; values sampled replace a random value, so FIFO order is lost
+		 * FULL_DECIMATE - every second value is removed in place and only every second value pushed afterwards is stored (size of at least 2),
+		 *                 repeated whenever the buffer is full again; values pushed to a full buffer in between are dropped until
+		 *                 one is accepted at the halved rate; getDecimation returns the number of values pushed per value stored
+		 * Policies apply to push, values written by reserve/write/commit always overwrite the oldest ones.
+		 */
+		byte getFullPolicy();
+		void setFullPolicy(byte p_policy);
+		unsigned int getDecimation();
+		
+		/*
+		 * Time-based expiry for keeping the values of a time window instead of a number of values, e.g. the last 60 seconds.
+		 * Values older than p_ttl milliseconds are skipped by all methods reading from buffer (getValueCount, getValue,
+		 * getNewest, scan, ...) and removed by the next method writing to or consuming from it (push, reserve, pop,
+		 * pop_back, push_front, setValue, updateValue), so readers never change the buffer. Timestamps are kept per block
+		 * of p_blockSize values in the order they were appended, the time of the latest value stored in the block, so values
+		 * expire together with the newest value of their block. getQuantile counts expired values until they are removed.
+		 *
+		 * returns: whether expiry could be enabled, false if memory is exhausted
+		 */
+		boolean enableTTL(unsigned long p_ttl, unsigned int p_blockSize);
+		void disableTTL();
+		
+		/*
+		 * Two-phase write for producers filling the buffer directly instead of pushing value by value.
+		 * reserve starts a write of up to p_count values at the current write position, write fills the reserved
+		 * slots one after another (wrapping at the end of the buffer) applying the overflow state, and commit
+		 * publishes the first p_count written values to getValue/pop at once. Values written but not committed are
+		 * discarded by the next reserve. Once the FIFO is full the reserved slots contain the oldest values, write
+		 * removes the oldest value like pop before overwriting its slot, so uncommitted values are never read and
+		 * slots reserved but not written cost no values, e.g. reserving the largest frame and committing what was
+		 * decoded. No other value may be pushed between reserve and commit.
+		 *
+		 * returns: number of reserved slots / whether value was written / number of published values
+		 */
+		unsigned int reserve(unsigned int p_count);
+		boolean write(unsigned int p_value);
+		unsigned int commit(unsigned int p_count);
+		
 		#if BB_DEBUG_LEVEL > 0
 		void runTest();
 		
@@ -101,6 +386,57 @@ class BitBuffer
 		#endif
 		
 	private:
+		friend class BitBufferSnapshot;
+		
+		// fixed point state of streaming statistics, values are scaled by 2^fraction to 16 bit
+		struct Statistics
+		{
+			long average; //EWMA of scaled values
+			unsigned long variance; //decayed variance of scaled values
+			long rate; //EWMA of change between consecutive scaled values
+			long lastValue; //latest scaled value
+			byte shift; //weight of latest value is 2^-shift
+			byte fraction; //number of fraction bits of scaled values
+			boolean initialized; //whether first value was pushed
+		};
+		
+		// state of trigger
+		struct Trigger
+		{
+			unsigned int level; //trigger level, lower bound for window
+			unsigned int upper; //upper bound for window
+			unsigned int preCount; //number of values required in front of trigger
+			unsigned int postCount; //number of values captured after trigger
+			unsigned int captured; //number of values pushed after trigger fired
+			unsigned int lastValue; //value pushed last while armed
+			void (*callback)(BitBuffer*); //called once capture is complete, NULL if not needed
+			byte mode; //trigger mode
+			byte state; //trigger state, 0 if not armed
+			boolean hasLastValue; //whether lastValue was pushed since trigger was armed
+		};
+		
+		// state of archive
+		struct Archive
+		{
+			BitBuffer* buffer; //buffer receiving the reduced blocks
+			unsigned long accumulator; //minimum, maximum or sum of the values of the current block
+			unsigned int blockSize; //number of values per block
+			unsigned int count; //number of values in current block
+			byte function; //reduction of a block
+			signed char shift; //difference in bits between values of archive and buffer
+		};
+		
+		// state of time-based expiry
+		struct TTL
+		{
+			unsigned long ttl; //time in milliseconds values are kept
+			unsigned int blockSize; //number of values sharing a timestamp
+			unsigned int blockCount; //number of timestamps, one more than blocks of values fitting into buffer
+			unsigned long position; //position of the next value appended within the blocks
+			unsigned int expired; //number of values in front of the buffer known to be expired, reset by every write
+			unsigned long stamps[1]; //time of latest value stored per block
+		};
+		
 		// ###### VARIABLES #####
 		byte s_range; //value range
 		byte s_overflow; //overflow behaviour
@@ -110,11 +446,29 @@ class BitBuffer
 		unsigned int s_size; //capacity of values that can be stored in buffer for defined range
 		unsigned int s_bitSize; //number of bits per value for defined range
 		boolean s_full; //keep state whether first overrun of FIFO happened already
+		unsigned int s_valueCount; //number of values stored, including expired values not removed yet
+		unsigned int s_lowWatermark; //fill level on which callback is called with WATERMARK_LOW
+		unsigned int s_highWatermark; //fill level on which callback is called with WATERMARK_HIGH
+		unsigned int s_risingWatermark; //lowest watermark above fill level, 0 if none
+		unsigned int s_fallingWatermark; //highest watermark at or below fill level, 0 if none
+		void (*s_watermarkCallback)(BitBuffer*, byte); //callback for watermarks, NULL if disabled
+		BitWriter s_writer; //writer filling the reserved slots
+		unsigned int s_reserveCount; //number of slots reserved for write
+		unsigned int s_writeCount; //number of values written to reserved slots but not yet committed
+		volatile unsigned int s_sequence; //seqlock sequence, odd while buffer is changed by writer
+		BitBufferSnapshot* s_snapshots; //snapshots referencing the byte array, NULL if none
+		unsigned int* s_histogram; //Fenwick tree of the number of values per value, NULL if not enabled
+		Statistics* s_statistics; //streaming statistics, NULL if not enabled
+		Trigger* s_trigger; //trigger, NULL if not set
+		Archive* s_archive; //archive receiving values leaving the buffer, NULL if not set
+		byte s_fullPolicy; //behaviour once buffer is full
+		unsigned long s_seenCount; //number of values pushed since full policy was set
+		unsigned int s_decimation; //number of values pushed per value stored for FULL_DECIMATE
+		TTL* s_ttl; //timestamps for time-based expiry, NULL if not enabled
 
 		// ##### METHODS #####
 		// returns the maximum value that can be stored in buffer for defined range.
 		unsigned int getMaxRangeValue();
-		unsigned int getMaxRangeValue(byte p_range);
 		
 		/*
 		 * returns size of values in bits for defined range
@@ -127,11 +481,132 @@ class BitBuffer
 		// returns the size of the byte array for internal calculation
 		unsigned int getArraySize();
 
+		// maps the value to the defined range according to overflow state, returns false if value is to be skipped
+		boolean mapToRange(unsigned int* p_value);
+		
+		// returns the bit index the next value will be written to
+		unsigned long getWriteBitIndex();
+		
+		// moves bitIndex behind the value written at getWriteBitIndex() and updates fill level
+		void advanceBitIndex();
+		
+		// calls watermark callback for every watermark the fill level crossed / precomputes the watermarks crossed next
+		void checkWatermarks();
+		void updateWatermarks();
+		
+		/*
+		 * Seqlock handling
+		 * beginWrite/endWrite enclose all changes to the buffer, readSequence returns the current sequence
+		 */
+		void beginWrite();
+		void endWrite();
+		unsigned int readSequence();
+		
+		/*
+		 * Maps the index in FIFO (starting with 1) to the bit index of the value in the byte array
+		 */
+		unsigned long getBitIndex(unsigned p_index);
+		
+		/*
+		 * Maps the index counted from the newest value (starting with 1) to the bit index of the value in the byte array
+		 */
+		unsigned long getNewestBitIndex(unsigned p_index);
+		
 		/*
 		 * Returns the value for the defined bitIndex
 		 */
 		unsigned int getValueInternal(unsigned long p_bitIndex);
 		
-		//performs a transformation of two byte into an integer
-		unsigned int getIntegerValue(byte highByte, byte lowByte);
+		/*
+		 * Writes the value to the defined bitIndex
+		 */
+		void setValueInternal(unsigned long p_bitIndex, unsigned int p_value);
+		
+		// copies the pages containing the defined bytes into all snapshots before they get overwritten
+		void preserveBytes(unsigned int p_firstByte, unsigned int p_lastByte);
+		
+		/*
+		 * Hooks for features following the values in buffer, called for every value added to and removed from buffer
+		 * hasHooks returns whether any of those features is enabled, otherwise values need not be read for the hooks
+		 * p_evicted: whether value left the buffer by pop or by being overwritten instead of being changed or taken back
+		 */
+		boolean hasHooks();
+		void valueAdded(unsigned int p_value);
+		void valueRemoved(unsigned int p_value, boolean p_evicted);
+		
+		// returns whether p_buffer shares bits per value, size and write position with this buffer and both need no per value processing on push
+		boolean isLockstep(BitBuffer* p_buffer);
+		
+		// pushes the value to the write position given as byte index and shift of the value within the 3 bytes starting there
+		boolean pushLockstep(unsigned int p_value, unsigned long p_byteIndex, byte p_shift);
+		
+		// adds the value leaving the buffer to the current block of the archive
+		void archiveValue(unsigned int p_value);
+		
+		/*
+		 * Applies the full policy to the value pushed
+		 * p_stored: receives whether value was stored if it is not to be appended
+		 * returns: whether value is to be appended by push
+		 */
+		boolean sampleValue(unsigned int p_value, boolean* p_stored);
+		
+		// removes every second value in place and doubles the decimation
+		void decimate();
+		
+		// sets the timestamp of the block of the value appended / removes expired values
+		void stampValue();
+		void expireValues();
+		
+		/*
+		 * Maps the index counted from the newest value (starting with 1) to the position of the value in the blocks of timestamps
+		 */
+		unsigned long getStampPosition(unsigned p_index);
+		
+		// returns the number of expired values in front of the buffer without removing them, resuming behind the values known to be expired
+		unsigned int getExpiredCount();
+		
+		// returns the number of values stored in buffer including expired values not removed yet
+		unsigned int getStoredCount();
+		
+		// changes the number of values p_value by p_delta in the histogram
+		void updateHistogram(unsigned int p_value, int p_delta);
+		
+		// updates streaming statistics by the value pushed
+		void updateStatistics(unsigned int p_value);
+		
+		/*
+		 * Checks the value to be pushed against the trigger, completeTrigger is called once the value was stored
+		 * returns: whether value may be stored, false if the capture is complete / number of values that may be stored
+		 */
+		boolean checkTrigger(unsigned int p_value);
+		void completeTrigger();
+		unsigned int getTriggerCapacity();
+		
+		/*
+		 * Returns the bit ranges of the values in buffer in FIFO order, the second one starting at bit 0 once the values wrap
+		 * p_bitIndex, p_bitCount: arrays of two receiving start and length of each range
+		 * returns: number of ranges (0 - 2)
+		 */
+		byte getWindow(unsigned long* p_bitIndex, unsigned long* p_bitCount);
+		
+		/*
+		 * Lane-wise comparison of 32 bit words holding 32 / getBitSize() values, p_highBits has the most significant bit of each value set
+		 * returns: most significant bit of each value set where p_a is less than / equal to p_b
+		 */
+		uint32_t lessLanes(uint32_t p_a, uint32_t p_b, uint32_t p_highBits);
+		uint32_t equalLanes(uint32_t p_a, uint32_t p_b, uint32_t p_highBits);
+		
+		// returns the most significant bit of each value set where the value matches the scan operator
+		uint32_t matchLanes(uint32_t p_word, byte p_operator, uint32_t p_value, uint32_t p_upper, uint32_t p_highBits);
+		
+		// returns 32 bit of the array starting at p_wordIndex, a multiple of 32
+		uint32_t getWord(unsigned long p_wordIndex);
+		
+		// single pass over all values in buffer computing the requested aggregates, pointers of aggregates not needed are NULL
+		void aggregate(unsigned long* p_sum, unsigned int* p_min, unsigned int* p_max, unsigned int* p_counts, unsigned int p_binCount);
+		
+		// returns the sum of all values of a 32 bit word holding 32 / getBitSize() values
+		uint32_t sumLanes(uint32_t p_word);
 };
+
+#endif
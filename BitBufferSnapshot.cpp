@@ -0,0 +1,209 @@
+/*
+ *	Arduino BitBuffer - snapshots
+ *	stable, read-only view of a BitBuffer based on copy-on-write pages, see BitBufferSnapshot.h
+ */
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "BitBufferSnapshot.h"
+#include "BitStream.h"
+
+// compiler barrier, keeps the page table lookup from being reordered with the read of the buffer
+#define BB_MEMORY_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+/*
+ * Constructor
+ * p_buffer - buffer whose current values are kept by the snapshot
+ */
+BitBufferSnapshot::BitBufferSnapshot(BitBuffer* p_buffer) {
+	s_buffer = p_buffer;
+	s_bitIndex = p_buffer->s_bitIndex;
+	s_valueCount = p_buffer->getValueCount();
+	s_size = p_buffer->getSize();
+	s_bitSize = p_buffer->getBitSize();
+
+	//pages are only copied once the buffer is about to overwrite them, the page table starts empty
+	//memory for all page copies is allocated now, so the writer (e.g. an interrupt routine) never allocates memory
+	s_pageCount = (p_buffer->getArraySize() + BB_SNAPSHOT_PAGE_SIZE - 1) / BB_SNAPSHOT_PAGE_SIZE;
+	s_pages = (byte**)calloc(s_pageCount, sizeof(byte*));
+	s_pool = (byte*)malloc(p_buffer->getArraySize());
+	s_valid = s_pages != NULL && s_pool != NULL;
+	s_next = NULL;
+
+	//without page table or page copies the snapshot cannot keep any value, so it is not attached to the buffer
+	if(!s_valid)
+	{
+		free(s_pages);
+		free(s_pool);
+		s_pages = NULL;
+		s_pool = NULL;
+		s_buffer = NULL;
+		s_valueCount = 0;
+		return;
+	}
+
+	s_next = p_buffer->s_snapshots;
+	p_buffer->s_snapshots = this;
+
+	#if BB_DEBUG_LEVEL > 0
+	Serial.print("Snapshot::Page count: ");
+	Serial.println(s_pageCount);
+	#endif
+}
+
+BitBufferSnapshot::~BitBufferSnapshot() {
+	release();
+}
+
+/*
+ * Detaches snapshot from buffer and frees copied pages, afterwards snapshot contains no values.
+ */
+void BitBufferSnapshot::release() {
+	if(s_buffer != NULL && s_valid)
+		detach();
+	s_buffer = NULL;
+
+	free(s_pages);
+	free(s_pool);
+	s_pages = NULL;
+	s_pool = NULL;
+
+	s_valueCount = 0;
+}
+
+/*
+ * Returns whether the snapshot holds the values of the buffer, false if memory for the page table
+ * and page copies was exhausted when the snapshot was created.
+ */
+boolean BitBufferSnapshot::isValid() {
+	return s_valid;
+}
+
+// returns capacity of values of the buffer the snapshot was taken from
+unsigned int BitBufferSnapshot::getSize() {
+	return s_size;
+}
+
+// returns the number of values stored in buffer at the time the snapshot was taken
+unsigned int BitBufferSnapshot::getValueCount() {
+	return s_valueCount;
+}
+
+/*
+ * Returns the specified index in the snapshot, corresponds to BitBuffer::getValue at the time the snapshot was taken.
+ *
+ * p_index: index in FIFO starting with 1
+ * returns: value at specified index or 0 in case of invalid index
+ */
+unsigned int BitBufferSnapshot::getValue(unsigned p_index) {
+	unsigned int ret = 0;
+
+	getValues(p_index, &ret, 1);
+
+	return ret;
+}
+
+/*
+ * Retrieval of p_count values starting at the specified index in FIFO
+ *
+ * p_index: index in FIFO starting with 1
+ * returns: number of values written to p_values
+ */
+unsigned int BitBufferSnapshot::getValues(unsigned p_index, unsigned int* p_values, unsigned int p_count) {
+	//check whether index is filled in snapshot
+	if(s_valueCount < p_index || p_index < 1)
+		return 0;
+
+	if(p_count > s_valueCount - p_index + 1)
+		p_count = s_valueCount - p_index + 1;
+
+	unsigned long bitLimit = (unsigned long) s_size * s_bitSize;
+	unsigned long bitDelta = (unsigned long) (s_valueCount - p_index + 1) * s_bitSize;
+	unsigned long bitIndex;
+
+	// check if we have to take the value from the end of the buffer
+	if(bitDelta <= s_bitIndex)
+		bitIndex = s_bitIndex - bitDelta;
+	else
+		bitIndex = bitLimit - bitDelta + s_bitIndex;
+
+	for(unsigned int i = 0; i < p_count; i++)
+	{
+		//a value spans at most three bytes, those are collected from pages and buffer and decoded as usual
+		byte bytes[3];
+		unsigned int firstByte = bitIndex / 8;
+		unsigned int lastByte = (bitIndex + s_bitSize - 1) / 8;
+
+		for(unsigned int j = firstByte; j <= lastByte; j++)
+			bytes[j - firstByte] = getByte(j);
+
+		BitReader reader(bytes, bitIndex % 8, 0);
+		p_values[i] = reader.read(s_bitSize);
+
+		bitIndex += s_bitSize;
+		if(bitIndex + s_bitSize > bitLimit)
+			bitIndex = 0;
+	}
+
+	return p_count;
+}
+
+/*
+ * Copies the pages containing the defined bytes of the buffer unless they were copied before.
+ * Called by the buffer before the bytes get overwritten, pages are copied into the memory allocated with the snapshot.
+ */
+void BitBufferSnapshot::preserve(unsigned int p_firstByte, unsigned int p_lastByte) {
+	for(unsigned int page = p_firstByte / BB_SNAPSHOT_PAGE_SIZE; page <= p_lastByte / BB_SNAPSHOT_PAGE_SIZE; page++)
+	{
+		if(s_pages[page] != NULL)
+			continue;
+
+		//last page might be shorter than page size
+		unsigned int offset = page * BB_SNAPSHOT_PAGE_SIZE;
+		unsigned int length = s_buffer->getArraySize() - offset;
+		if(length > BB_SNAPSHOT_PAGE_SIZE)
+			length = BB_SNAPSHOT_PAGE_SIZE;
+
+		byte* copy = &s_pool[offset];
+		memcpy(copy, &s_buffer->s_data[offset], length);
+
+		BB_MEMORY_BARRIER();
+		s_pages[page] = copy;
+
+		#if BB_DEBUG_LEVEL > 1
+		Serial.print("Snapshot::Copied page: ");
+		Serial.println(page);
+		#endif
+	}
+}
+
+// removes snapshot from the list of snapshots of the buffer
+void BitBufferSnapshot::detach() {
+	BitBufferSnapshot** snapshot = &s_buffer->s_snapshots;
+
+	while(*snapshot != this)
+		snapshot = &(*snapshot)->s_next;
+
+	*snapshot = s_next;
+}
+
+// returns the byte of the byte array at the time the snapshot was taken
+byte BitBufferSnapshot::getByte(unsigned int p_index) {
+	unsigned int page = p_index / BB_SNAPSHOT_PAGE_SIZE;
+
+	if(s_pages[page] == NULL)
+	{
+		byte ret = s_buffer->s_data[p_index];
+
+		//buffer copies the page before overwriting it, if it is still not copied the byte read is unchanged
+		BB_MEMORY_BARRIER();
+		if(s_pages[page] == NULL)
+			return ret;
+	}
+
+	return s_pages[page][p_index % BB_SNAPSHOT_PAGE_SIZE];
+}
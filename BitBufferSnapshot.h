@@ -0,0 +1,107 @@
+/*
+ *	Arduino BitBuffer - snapshots
+ *	A BitBufferSnapshot is a stable, read-only view of a BitBuffer at the time the snapshot was created,
+ *	e.g. for long running analysis while values keep being pushed. Creating a snapshot does not copy the
+ *	values, it only copies the buffer state and allocates an empty page table. The byte array of the buffer
+ *	is divided into pages of BB_SNAPSHOT_PAGE_SIZE bytes; before the buffer overwrites a page for the first
+ *	time the page is copied into every snapshot still referencing it (copy-on-write), all other pages are
+ *	read directly from the buffer.
+ *
+ *	Snapshots have to be created from the context writing to the buffer. Memory for the page table and for
+ *	copies of all pages is allocated when the snapshot is created, so copying a page on write never allocates
+ *	memory, e.g. within an interrupt routine pushing values. Releasing or destroying the buffer's byte array
+ *	by flush() copies all remaining pages, so snapshots stay valid afterwards. If memory is exhausted when the
+ *	snapshot is created it is not attached to the buffer and invalid, see isValid().
+ */
+
+#ifndef BitBufferSnapshot_h
+#define BitBufferSnapshot_h
+
+// number of bytes copied at once once the buffer overwrites values referenced by a snapshot
+#define BB_SNAPSHOT_PAGE_SIZE 16
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "BitBuffer.h"
+
+class BitBufferSnapshot
+{
+	public:
+		// ##### CONSTRUCTOR #####
+		// p_buffer - buffer whose current values are kept by the snapshot
+		BitBufferSnapshot(BitBuffer* p_buffer);
+		~BitBufferSnapshot();
+
+		// ##### METHODS #####
+		/*
+		 * Detaches snapshot from buffer and frees copied pages, afterwards snapshot contains no values.
+		 * This is done by the destructor as well.
+		 */
+		void release();
+
+		/*
+		 * Returns whether the snapshot holds the values of the buffer, false if memory for the page table
+		 * and page copies was exhausted when the snapshot was created. Invalid snapshots contain no values.
+		 */
+		boolean isValid();
+
+		// returns capacity of values of the buffer the snapshot was taken from
+		unsigned int getSize();
+
+		// returns the number of values stored in buffer at the time the snapshot was taken
+		unsigned int getValueCount();
+
+		/*
+		 * Returns the specified index in the snapshot, corresponds to BitBuffer::getValue at the time the snapshot was taken.
+		 *
+		 * p_index: index in FIFO starting with 1
+		 * returns: value at specified index or 0 in case of invalid index
+		 */
+		unsigned int getValue(unsigned p_index);
+
+		/*
+		 * Retrieval of p_count values starting at the specified index in FIFO
+		 *
+		 * p_index: index in FIFO starting with 1
+		 * returns: number of values written to p_values
+		 */
+		unsigned int getValues(unsigned p_index, unsigned int* p_values, unsigned int p_count);
+
+	private:
+		friend class BitBuffer;
+
+		// ###### VARIABLES #####
+		BitBuffer* s_buffer; //buffer the snapshot was taken from, NULL once all pages are copied or snapshot was released
+		BitBufferSnapshot* s_next; //next snapshot of the same buffer
+		byte** s_pages; //page table, NULL for pages still read from buffer
+		byte* s_pool; //memory for the copies of all pages, page i is copied to offset i * BB_SNAPSHOT_PAGE_SIZE
+		unsigned int s_pageCount; //number of pages of the byte array
+		unsigned long s_bitIndex; //location index for next write on bitlevel at the time the snapshot was taken
+		unsigned int s_valueCount; //number of values at the time the snapshot was taken
+		unsigned int s_size; //capacity of values that can be stored in buffer for defined range
+		byte s_bitSize; //number of bits per value for defined range
+		boolean s_valid; //whether memory for page table and page copies could be allocated
+
+		// ##### METHODS #####
+		// snapshots are referenced by the buffer and must not be copied
+		BitBufferSnapshot(const BitBufferSnapshot&);
+		BitBufferSnapshot& operator=(const BitBufferSnapshot&);
+
+		/*
+		 * Copies the pages containing the defined bytes of the buffer unless they were copied before.
+		 * Called by the buffer before the bytes get overwritten.
+		 */
+		void preserve(unsigned int p_firstByte, unsigned int p_lastByte);
+
+		// removes snapshot from the list of snapshots of the buffer
+		void detach();
+
+		// returns the byte of the byte array at the time the snapshot was taken
+		byte getByte(unsigned int p_index);
+};
+
+#endif
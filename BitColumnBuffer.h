@@ -0,0 +1,301 @@
+/*
+ *	Arduino BitBuffer - column buffer
+ *	BitColumnBuffer stores the same records as BitRecordBuffer column by column: each field has its own packed byte array
+ *	while all columns share one write position and record count. Appending a record writes every column at the same index,
+ *	reading or scanning one field only touches the bytes of its column, e.g. 10 of 14 bits per record for the level
+ *	of BitRecordBuffer<3, 10, 1>.
+ *
+ *	Records are moved between both layouts with seal / unseal, e.g. collecting in BitRecordBuffer and sealing into
+ *	BitColumnBuffer for analysis. As a template it is implemented in this header only.
+ */
+
+#ifndef BitColumnBuffer_h
+#define BitColumnBuffer_h
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "BitBuffer.h"
+#include "BitStream.h"
+#include "BitRecordBuffer.h"
+
+template<byte... Widths>
+class BitColumnBuffer
+{
+	public:
+		typedef BitRecordLayout<Widths...> Layout;
+
+		// ##### CONSTANTS #####
+		// number of fields and bits per record
+		static constexpr byte FIELD_COUNT = sizeof...(Widths);
+		static constexpr byte RECORD_SIZE = Layout::getRecordSize();
+
+		static_assert(FIELD_COUNT > 0, "BitColumnBuffer requires at least one field");
+		static_assert(Layout::hasValidWidths(), "BitColumnBuffer fields are limited to 1 - 16 bits");
+
+		// ##### CONSTRUCTOR #####
+		/*
+		 * p_size - defines the number of records in this FIFO store before records will be overwritten
+		 */
+		BitColumnBuffer(unsigned int p_size) {
+			s_size = p_size;
+			s_count = 0;
+			s_head = 0;
+			s_overflow = BitBuffer::OVERFLOW_SKIP;
+
+			for(byte field = 0; field < FIELD_COUNT; field++)
+				s_data[field] = (byte*)malloc(((unsigned long) p_size * getFieldWidth(field) + 7) / 8);
+		}
+
+		// ##### METHODS #####
+		/*
+		 * Resets buffer instance and frees memory
+		 */
+		void flush() {
+			for(byte field = 0; field < FIELD_COUNT; field++)
+			{
+				free(s_data[field]);
+				s_data[field] = NULL;
+			}
+			s_size = 0;
+			s_count = 0;
+			s_head = 0;
+		}
+
+		/*
+		 * Overflow handling per field, see BitBuffer
+		 * OVERFLOW_SKIP skips the whole record if one of its fields is beyond its width
+		 */
+		byte getOverflowState() {
+			return s_overflow;
+		}
+
+		void setOverflowState(byte p_overflow) {
+			s_overflow = p_overflow;
+		}
+
+		// returns capacity of records / number of records currently stored in buffer
+		unsigned int getSize() {
+			return s_size;
+		}
+
+		unsigned int getRecordCount() {
+			return s_count;
+		}
+
+		// returns the width of the field in bits
+		static constexpr byte getFieldWidth(byte p_field) {
+			return Layout::getWidth(p_field);
+		}
+
+		/*
+		 * Central methods for filling and retrieving records, the FIFO replaces the oldest record once capacity is reached.
+		 * All fields are checked before the first column is written, so a skipped record leaves every column untouched.
+		 * p_fields: array of FIELD_COUNT values, one per field in order of the template parameters
+		 *
+		 * returns: whether record was stored / retrieved
+		 */
+		boolean pushRecord(const unsigned int* p_fields) {
+			unsigned int values[FIELD_COUNT];
+
+			if(!hasMemory())
+				return false;
+
+			for(byte field = 0; field < FIELD_COUNT; field++)
+			{
+				values[field] = p_fields[field];
+				if(!BitBuffer::mapToRange(&values[field], getMaxFieldValue(field), s_overflow))
+					return false;
+			}
+
+			for(byte field = 0; field < FIELD_COUNT; field++)
+			{
+				BitWriter writer(s_data[field], (unsigned long) s_head * getFieldWidth(field), 0);
+				writer.write(values[field], getFieldWidth(field));
+				writer.flush();
+			}
+
+			s_head = s_head + 1 < s_size ? s_head + 1 : 0;
+			if(s_count < s_size)
+				s_count++;
+
+			return true;
+		}
+
+		boolean popRecord(unsigned int* p_fields) {
+			if(!getRecord(1, p_fields))
+				return false;
+
+			s_count--;
+			return true;
+		}
+
+		/*
+		 * Returns the record / a single field of the record at the specified index in FIFO without deleting it.
+		 *
+		 * p_index: index in FIFO starting with 1
+		 * returns: whether record was retrieved / value of field or 0 in case of invalid index
+		 */
+		boolean getRecord(unsigned int p_index, unsigned int* p_fields) {
+			if(!hasMemory() || p_index < 1 || p_index > s_count)
+				return false;
+
+			for(byte field = 0; field < FIELD_COUNT; field++)
+				p_fields[field] = getField(p_index, field);
+
+			return true;
+		}
+
+		unsigned int getField(unsigned int p_index, byte p_field) {
+			if(p_index < 1 || p_index > s_count || p_field >= FIELD_COUNT || s_data[p_field] == NULL)
+				return 0;
+
+			BitReader reader(s_data[p_field], (unsigned long) getPosition(p_index) * getFieldWidth(p_field), 0);
+			return reader.read(getFieldWidth(p_field));
+		}
+
+		/*
+		 * Bulk extraction of one field of p_count records starting at the specified index in FIFO.
+		 * Only the column of the field is read, values are streamed through one reader wrapping at the end of the column.
+		 *
+		 * p_index: index in FIFO starting with 1
+		 * returns: number of values written to p_values
+		 */
+		unsigned int getColumn(byte p_field, unsigned int p_index, unsigned int* p_values, unsigned int p_count) {
+			if(p_index < 1 || p_index > s_count || p_field >= FIELD_COUNT || s_data[p_field] == NULL)
+				return 0;
+
+			if(p_count > s_count - p_index + 1)
+				p_count = s_count - p_index + 1;
+
+			byte width = getFieldWidth(p_field);
+			BitReader reader(s_data[p_field], (unsigned long) getPosition(p_index) * width, (unsigned long) s_size * width);
+
+			for(unsigned int i = 0; i < p_count; i++)
+				p_values[i] = reader.read(width);
+
+			return p_count;
+		}
+
+		/*
+		 * Predicate scan over one field of all records in buffer, see BitBuffer::scan for operators and bitmap
+		 * Only the column of the field is read.
+		 *
+		 * returns: number of records matching
+		 */
+		unsigned int scan(byte p_field, byte p_operator, unsigned int p_value, unsigned int p_upper = 0, byte* p_bitmap = NULL) {
+			unsigned int count = 0;
+
+			if(p_bitmap != NULL)
+				memset(p_bitmap, 0, (s_count + 7) / 8);
+
+			if(p_field >= FIELD_COUNT || s_count == 0 || s_data[p_field] == NULL)
+				return 0;
+
+			byte width = getFieldWidth(p_field);
+			BitReader reader(s_data[p_field], (unsigned long) getPosition(1) * width, (unsigned long) s_size * width);
+
+			for(unsigned int index = 0; index < s_count; index++)
+			{
+				unsigned int value = reader.read(width);
+				boolean match;
+
+				if(p_operator == BitBuffer::SCAN_EQUAL)
+					match = value == p_value;
+				else if(p_operator == BitBuffer::SCAN_NOT_EQUAL)
+					match = value != p_value;
+				else if(p_operator == BitBuffer::SCAN_LESS)
+					match = value < p_value;
+				else
+					match = value >= p_value && value <= p_upper;
+
+				if(match)
+				{
+					count++;
+					if(p_bitmap != NULL)
+						p_bitmap[index / 8] |= 0x80 >> (index % 8);
+				}
+			}
+
+			return count;
+		}
+
+		/*
+		 * Moves all records from the row buffer into this buffer, the records are popped from p_records in FIFO order
+		 * and appended behind the records of this buffer. unseal moves the records of this buffer the same way back.
+		 *
+		 * returns: number of records moved
+		 */
+		unsigned int seal(BitRecordBuffer<Widths...>* p_records) {
+			unsigned int fields[FIELD_COUNT];
+			unsigned int count = 0;
+
+			//records popped could not be stored
+			if(!hasMemory())
+				return 0;
+
+			while(p_records->popRecord(fields))
+			{
+				if(pushRecord(fields))
+					count++;
+			}
+
+			return count;
+		}
+
+		unsigned int unseal(BitRecordBuffer<Widths...>* p_records) {
+			unsigned int fields[FIELD_COUNT];
+			unsigned int count = 0;
+
+			while(popRecord(fields))
+			{
+				if(p_records->pushRecord(fields))
+					count++;
+			}
+
+			return count;
+		}
+
+	private:
+		// ###### VARIABLES #####
+		byte* s_data[FIELD_COUNT]; //dataset arrays, one per field
+		unsigned int s_head; //position of next record to be written
+		unsigned int s_size; //capacity of records
+		unsigned int s_count; //number of records stored
+		byte s_overflow; //overflow behaviour
+
+		// ##### METHODS #####
+		// returns whether capacity was requested and memory could be allocated for every column
+		boolean hasMemory() {
+			if(s_size == 0)
+				return false;
+
+			for(byte field = 0; field < FIELD_COUNT; field++)
+			{
+				if(s_data[field] == NULL)
+					return false;
+			}
+
+			return true;
+		}
+
+		// returns the maximum value of the field
+		static constexpr unsigned int getMaxFieldValue(byte p_field) {
+			return (unsigned int) ((1UL << getFieldWidth(p_field)) - 1);
+		}
+
+		// maps the index in FIFO (starting with 1) to the position of the record within the columns
+		unsigned int getPosition(unsigned int p_index) {
+			unsigned int delta = s_count - p_index + 1;
+
+			if(delta <= s_head)
+				return s_head - delta;
+
+			return s_size - delta + s_head;
+		}
+};
+
+#endif
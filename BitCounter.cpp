@@ -0,0 +1,148 @@
+/*
+ *	Arduino BitBuffer - packed counters
+ *	array of saturating counters packed into 32 bit words, see BitCounter.h
+ */
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "BitCounter.h"
+
+// counters are updated by compare-and-swap where it is lock-free for 32 bit words, otherwise within an atomic block
+#if !defined(__AVR__) && ((__SIZEOF_INT__ == 4 && __GCC_ATOMIC_INT_LOCK_FREE == 2) || (__SIZEOF_LONG__ == 4 && __GCC_ATOMIC_LONG_LOCK_FREE == 2))
+#define BB_COUNTER_CAS 1
+#else
+#define BB_COUNTER_CAS 0
+#endif
+
+/*
+ * Constructor
+ * p_range - defines the max value of a counter, use the public constants of BitBuffer
+ * p_size - defines the number of counters
+ */
+BitCounter::BitCounter(byte p_range, unsigned int p_size) {
+	s_size = p_size;
+	s_maxValue = BitBuffer::getMaxRangeValue(p_range);
+	s_bitSize = BitBuffer::getBitSize(p_range);
+	s_wordSize = 32 / s_bitSize;
+
+	s_data = (uint32_t*)calloc(getWordCount(), sizeof(uint32_t));
+
+	#if BB_DEBUG_LEVEL > 0
+	Serial.print("BitCounter::Word count: ");
+	Serial.println(getWordCount());
+	#endif
+}
+
+/*
+ * Resets counter instance and frees memory
+ */
+void BitCounter::flush() {
+	free(s_data);
+	s_data = NULL;
+	s_size = 0;
+}
+
+// returns the number of counters
+unsigned int BitCounter::getSize() {
+	return s_size;
+}
+
+/*
+ * Returns the value of the counter, p_index starting with 0
+ */
+unsigned int BitCounter::getValue(unsigned int p_index) {
+	if(p_index >= s_size)
+		return 0;
+
+	//first counter of a word is stored in the most significant bits like in BitBuffer
+	byte shift = 32 - (p_index % s_wordSize + 1) * s_bitSize;
+
+	#if BB_COUNTER_CAS
+	uint32_t word = __atomic_load_n(&s_data[p_index / s_wordSize], __ATOMIC_RELAXED);
+	#else
+	uint32_t word;
+	BB_ATOMIC_BLOCK
+	{
+		word = s_data[p_index / s_wordSize];
+	}
+	#endif
+
+	return (word >> shift) & s_maxValue;
+}
+
+/*
+ * Saturating update of the counter, p_index starting with 0
+ * returns: value of the counter after update
+ */
+unsigned int BitCounter::increment(unsigned int p_index) {
+	return add(p_index, 1);
+}
+
+unsigned int BitCounter::decrement(unsigned int p_index) {
+	return add(p_index, -1);
+}
+
+unsigned int BitCounter::add(unsigned int p_index, int p_delta) {
+	if(p_index >= s_size)
+		return 0;
+
+	uint32_t* word = &s_data[p_index / s_wordSize];
+	byte shift = 32 - (p_index % s_wordSize + 1) * s_bitSize;
+	uint32_t mask = (uint32_t) s_maxValue << shift;
+	unsigned int value;
+
+	#if BB_COUNTER_CAS
+	uint32_t current = __atomic_load_n(word, __ATOMIC_RELAXED);
+	uint32_t updated;
+
+	//another context might update a counter of the same word meanwhile, a failed exchange reloads current and the update is repeated
+	do
+	{
+		value = saturate((current & mask) >> shift, p_delta);
+		updated = (current & ~mask) | ((uint32_t) value << shift);
+	} while(updated != current && !__atomic_compare_exchange_n(word, &current, updated, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+	#else
+	BB_ATOMIC_BLOCK
+	{
+		value = saturate((*word & mask) >> shift, p_delta);
+		*word = (*word & ~mask) | ((uint32_t) value << shift);
+	}
+	#endif
+
+	return value;
+}
+
+/*
+ * Sets all counters to 0
+ */
+void BitCounter::reset() {
+	BB_ATOMIC_BLOCK
+	{
+		memset(s_data, 0, getWordCount() * sizeof(uint32_t));
+	}
+}
+
+/*####################################
+ *      INTERNAL PROCESSING METHODS
+ *####################################
+ */
+// returns the number of words of the dataset array
+unsigned int BitCounter::getWordCount() {
+	return (s_size + s_wordSize - 1) / s_wordSize;
+}
+
+// returns p_value changed by p_delta, saturated at the maximum value of the range and at 0 like OVERFLOW_MAX
+unsigned int BitCounter::saturate(unsigned int p_value, int p_delta) {
+	long value = (long) p_value + p_delta;
+
+	if(value > (long) s_maxValue)
+		return s_maxValue;
+	if(value < 0)
+		return 0;
+
+	return value;
+}
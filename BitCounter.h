@@ -0,0 +1,77 @@
+/*
+ *	Arduino BitBuffer - packed counters
+ *	BitCounter is an array of small saturating counters within a defined range, e.g. per-bucket statistics with
+ *	4 to 8 bits per counter instead of a full integer. Counters stop at the maximum value of the range like
+ *	OVERFLOW_MAX of BitBuffer and at 0 when decremented.
+ *
+ *	Counters are packed into 32 bit words without crossing word boundaries, so each update touches exactly one
+ *	word (e.g. five 6 bit counters per word). Where the compiler offers lock-free 32 bit compare-and-swap the
+ *	update is a CAS loop on that word and counters can be updated concurrently, elsewhere interrupts are disabled
+ *	for the update instead.
+ */
+
+#ifndef BitCounter_h
+#define BitCounter_h
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "BitBuffer.h"
+
+class BitCounter
+{
+	public:
+		// ##### CONSTRUCTOR #####
+		/*
+		 * p_range - defines the max value of a counter, use the public constants of BitBuffer
+		 * p_size - defines the number of counters
+		 */
+		BitCounter(byte p_range, unsigned int p_size);
+
+		// ##### METHODS #####
+		/*
+		 * Resets counter instance and frees memory
+		 */
+		void flush();
+
+		// returns the number of counters
+		unsigned int getSize();
+
+		/*
+		 * Returns the value of the counter, p_index starting with 0
+		 */
+		unsigned int getValue(unsigned int p_index);
+
+		/*
+		 * Saturating update of the counter, p_index starting with 0
+		 * returns: value of the counter after update
+		 */
+		unsigned int increment(unsigned int p_index);
+		unsigned int decrement(unsigned int p_index);
+		unsigned int add(unsigned int p_index, int p_delta);
+
+		/*
+		 * Sets all counters to 0
+		 */
+		void reset();
+
+	private:
+		// ###### VARIABLES #####
+		uint32_t* s_data; //dataset array of words
+		unsigned int s_size; //number of counters
+		unsigned int s_maxValue; //maximum value of a counter
+		byte s_bitSize; //number of bits per counter
+		byte s_wordSize; //number of counters per word
+
+		// ##### METHODS #####
+		// returns the number of words of the dataset array
+		unsigned int getWordCount();
+
+		// returns p_value changed by p_delta, saturated at the maximum value of the range and at 0
+		unsigned int saturate(unsigned int p_value, int p_delta);
+};
+
+#endif
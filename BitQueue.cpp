@@ -0,0 +1,206 @@
+/*
+ *	Arduino BitBuffer - unbounded queue
+ *	linked list of chunks with packed values that grows instead of overwriting old values, see BitQueue.h
+ */
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "BitQueue.h"
+#include "BitStream.h"
+
+/*
+ * Constructor
+ * p_range - defines the max values to be stored in the queue, use the public constants of BitBuffer
+ * p_chunkSize - defines the number of values packed into one chunk
+ */
+BitQueue::BitQueue(byte p_range, unsigned int p_chunkSize) {
+	s_range = p_range;
+	s_overflow = BitBuffer::OVERFLOW_SKIP;
+	s_bitSize = BitBuffer::getBitSize(p_range);
+	s_chunkSize = p_chunkSize > 0 ? p_chunkSize : 1;
+	s_head = NULL;
+	s_tail = NULL;
+	s_cache = NULL;
+	s_cacheCount = 0;
+	s_headIndex = 0;
+	s_tailIndex = 0;
+	s_count = 0;
+
+	#if BB_DEBUG_LEVEL > 0
+	Serial.print("BitQueue::Chunk size in bytes: ");
+	Serial.println((s_chunkSize * s_bitSize + 7) / 8);
+	#endif
+}
+
+/*
+ * Resets queue instance and frees memory of all chunks
+ */
+void BitQueue::flush() {
+	while(s_head != NULL)
+	{
+		Chunk* chunk = s_head;
+		s_head = chunk->next;
+		free(chunk);
+	}
+
+	while(s_cache != NULL)
+	{
+		Chunk* chunk = s_cache;
+		s_cache = chunk->next;
+		free(chunk);
+	}
+
+	s_tail = NULL;
+	s_cacheCount = 0;
+	s_headIndex = 0;
+	s_tailIndex = 0;
+	s_count = 0;
+}
+
+/*
+ * Overflow handling, see BitBuffer
+ */
+byte BitQueue::getOverflowState() {
+	return s_overflow;
+}
+
+void BitQueue::setOverflowState(byte p_overflow) {
+	s_overflow = p_overflow;
+}
+
+// returns the number of values currently stored in queue
+unsigned long BitQueue::getValueCount() {
+	return s_count;
+}
+
+boolean BitQueue::push(unsigned int p_value) {
+	// check if value is within defined range
+	if(!BitBuffer::mapToRange(&p_value, BitBuffer::getMaxRangeValue(s_range), s_overflow))
+		return false;
+
+	//newest chunk is full, instead of wrapping a new chunk is appended
+	if(s_tail == NULL || s_tailIndex == s_chunkSize)
+	{
+		Chunk* chunk = allocateChunk();
+		if(chunk == NULL)
+			return false;
+
+		if(s_tail == NULL)
+			s_head = chunk;
+		else
+			s_tail->next = chunk;
+
+		s_tail = chunk;
+		s_tailIndex = 0;
+
+		#if BB_DEBUG_LEVEL > 1
+		Serial.print("BitQueue::Appended chunk for values: ");
+		Serial.println(s_count);
+		#endif
+	}
+
+	BitWriter writer(s_tail->data, (unsigned long) s_tailIndex * s_bitSize, 0);
+	writer.write(p_value, s_bitSize);
+	writer.flush();
+
+	s_tailIndex++;
+	s_count++;
+
+	return true;
+} //END push
+
+unsigned int BitQueue::pop() {
+	//check whether any values in queue left, if not we do not have a sufficient criteria to return error so we return 0
+	if(s_count == 0)
+		return 0;
+
+	BitReader reader(s_head->data, (unsigned long) s_headIndex * s_bitSize, 0);
+	unsigned int ret = reader.read(s_bitSize);
+
+	s_headIndex++;
+	s_count--;
+
+	//oldest chunk is drained, it is recycled unless it is the one values are pushed to
+	if(s_headIndex == s_chunkSize || s_count == 0)
+	{
+		Chunk* chunk = s_head;
+		s_headIndex = 0;
+
+		if(chunk == s_tail)
+		{
+			s_tailIndex = 0;
+		}
+		else
+		{
+			s_head = chunk->next;
+			releaseChunk(chunk);
+		}
+	}
+
+	return ret;
+} //END pop
+
+/*
+ * Returns the specified index in the queue without deleting it.
+ *
+ * p_index: index in FIFO starting with 1
+ * returns: value at specified index or 0 in case of invalid index
+ */
+unsigned int BitQueue::getValue(unsigned long p_index) {
+	//check whether index is currently filled in queue
+	if(s_count < p_index || p_index < 1)
+		return 0;
+
+	unsigned long index = s_headIndex + p_index - 1;
+	Chunk* chunk = s_head;
+
+	for(unsigned long i = index / s_chunkSize; i > 0; i--)
+		chunk = chunk->next;
+
+	BitReader reader(chunk->data, (index % s_chunkSize) * s_bitSize, 0);
+	return reader.read(s_bitSize);
+} //END getValue
+
+/*####################################
+ *      INTERNAL PROCESSING METHODS
+ *####################################
+ */
+// returns a chunk from cache or allocates a new one, NULL if no memory is left
+BitQueue::Chunk* BitQueue::allocateChunk() {
+	Chunk* chunk;
+
+	if(s_cache != NULL)
+	{
+		chunk = s_cache;
+		s_cache = chunk->next;
+		s_cacheCount--;
+	}
+	else
+	{
+		//chunk header is followed by packed values
+		chunk = (Chunk*)malloc(sizeof(Chunk) + (s_chunkSize * (unsigned long) s_bitSize + 7) / 8);
+		if(chunk == NULL)
+			return NULL;
+	}
+
+	chunk->next = NULL;
+	return chunk;
+}
+
+// keeps the drained chunk in cache or frees it
+void BitQueue::releaseChunk(Chunk* p_chunk) {
+	if(s_cacheCount < BB_QUEUE_CACHED_CHUNKS)
+	{
+		p_chunk->next = s_cache;
+		s_cache = p_chunk;
+		s_cacheCount++;
+	}
+	else
+	{
+		free(p_chunk);
+	}
+}
@@ -0,0 +1,96 @@
+/*
+ *	Arduino BitBuffer - unbounded queue
+ *	BitQueue stores values of a defined range like BitBuffer but never overwrites old values. Values are kept
+ *	in a linked list of chunks, each packing a fixed number of values. push appends a new chunk once the newest
+ *	one is full, pop releases the oldest chunk once it was drained. Existing values are never moved or copied,
+ *	so push takes the same time no matter how many values are queued. Up to BB_QUEUE_CACHED_CHUNKS drained
+ *	chunks are kept for reuse instead of being freed, which avoids heap fragmentation for bursty producers.
+ */
+
+#ifndef BitQueue_h
+#define BitQueue_h
+
+// number of drained chunks kept for reuse
+#define BB_QUEUE_CACHED_CHUNKS 2
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "BitBuffer.h"
+
+class BitQueue
+{
+	public:
+		// ##### CONSTRUCTOR #####
+		/*
+		 * p_range - defines the max values to be stored in the queue, use the public constants of BitBuffer
+		 * p_chunkSize - defines the number of values packed into one chunk
+		 */
+		BitQueue(byte p_range, unsigned int p_chunkSize);
+
+		// ##### METHODS #####
+		/*
+		 * Resets queue instance and frees memory of all chunks
+		 */
+		void flush();
+
+		/*
+		 * Overflow handling, see BitBuffer
+		 * OVERFLOW_MAX - the maximum value for this range will be written
+		 * OVERFLOW_MIN - zero will be written
+		 * OVERFLOW_SKIP - value will not be stored
+		 */
+		byte getOverflowState();
+		void setOverflowState(byte p_overflow);
+
+		// returns the number of values currently stored in queue
+		unsigned long getValueCount();
+
+		/*
+		 * central methods for queue to fill and retrieve values.
+		 * returns: whether value was stored, false if it was skipped or no memory was left for a new chunk / first value in queue
+		 */
+		boolean push(unsigned int p_value);
+		unsigned int pop();
+
+		/*
+		 * Returns the specified index in the queue without deleting it.
+		 *
+		 * p_index: index in FIFO starting with 1
+		 * returns: value at specified index or 0 in case of invalid index
+		 */
+		unsigned int getValue(unsigned long p_index);
+
+	private:
+		// chunk of packed values, allocated with the size of the packed values
+		struct Chunk
+		{
+			Chunk* next; //next newer chunk
+			byte data[1]; //packed values
+		};
+
+		// ###### VARIABLES #####
+		byte s_range; //value range
+		byte s_overflow; //overflow behaviour
+		unsigned int s_bitSize; //number of bits per value for defined range
+		unsigned int s_chunkSize; //number of values per chunk
+		Chunk* s_head; //oldest chunk values are popped from
+		Chunk* s_tail; //newest chunk values are pushed to
+		Chunk* s_cache; //drained chunks kept for reuse
+		byte s_cacheCount; //number of chunks in cache
+		unsigned int s_headIndex; //index of next value to pop within oldest chunk
+		unsigned int s_tailIndex; //index of next value to push within newest chunk
+		unsigned long s_count; //number of values in queue
+
+		// ##### METHODS #####
+		// returns a chunk from cache or allocates a new one, NULL if no memory is left
+		Chunk* allocateChunk();
+
+		// keeps the drained chunk in cache or frees it
+		void releaseChunk(Chunk* p_chunk);
+};
+
+#endif
@@ -0,0 +1,262 @@
+/*
+ *	Arduino BitBuffer - record buffer
+ *	BitRecordBuffer is a FIFO of records with several fields of different bit widths sharing one write position, e.g. samples
+ *	of (state: 3 bits, level: 10 bits, flag: 1 bit) stored in 14 bits instead of three BitBuffers with three cursors.
+ *	The field widths are template parameters, so offsets are computed at compile time and each record is packed into
+ *	one 32 bit word which is written with at most two writes.
+ *
+ *	BitRecordBuffer<3, 10, 1> buffer(100);
+ *	unsigned int record[] = {2, 512, 1};
+ *	buffer.pushRecord(record);
+ *
+ *	The whole record is limited to 32 bits, fields to 16 bits each. As a template it is implemented in this header only.
+ */
+
+#ifndef BitRecordBuffer_h
+#define BitRecordBuffer_h
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "BitBuffer.h"
+#include "BitStream.h"
+
+/*
+ * Compile time layout of the fields, offsets are counted from the most significant bit of the record like values in BitBuffer
+ * hasValidWidths returns whether every field has 1 to 16 bits, the width of values in BitBuffer
+ */
+template<byte... Widths>
+struct BitRecordLayout;
+
+template<>
+struct BitRecordLayout<>
+{
+	static constexpr byte getWidth(byte) { return 0; }
+	static constexpr byte getOffset(byte) { return 0; }
+	static constexpr byte getRecordSize() { return 0; }
+	static constexpr boolean hasValidWidths() { return true; }
+};
+
+template<byte First, byte... Rest>
+struct BitRecordLayout<First, Rest...>
+{
+	static constexpr byte getWidth(byte p_field) { return p_field == 0 ? First : BitRecordLayout<Rest...>::getWidth(p_field - 1); }
+	static constexpr byte getOffset(byte p_field) { return p_field == 0 ? 0 : First + BitRecordLayout<Rest...>::getOffset(p_field - 1); }
+	static constexpr byte getRecordSize() { return First + BitRecordLayout<Rest...>::getRecordSize(); }
+	static constexpr boolean hasValidWidths() { return First >= 1 && First <= 16 && BitRecordLayout<Rest...>::hasValidWidths(); }
+};
+
+template<byte... Widths>
+class BitRecordBuffer
+{
+	public:
+		typedef BitRecordLayout<Widths...> Layout;
+
+		// ##### CONSTANTS #####
+		// number of fields and bits per record
+		static constexpr byte FIELD_COUNT = sizeof...(Widths);
+		static constexpr byte RECORD_SIZE = Layout::getRecordSize();
+
+		static_assert(FIELD_COUNT > 0, "BitRecordBuffer requires at least one field");
+		static_assert(Layout::hasValidWidths(), "BitRecordBuffer fields are limited to 1 - 16 bits");
+		static_assert(RECORD_SIZE <= 32, "BitRecordBuffer records are limited to 32 bits");
+
+		// ##### CONSTRUCTOR #####
+		/*
+		 * p_size - defines the number of records in this FIFO store before records will be overwritten
+		 */
+		BitRecordBuffer(unsigned int p_size) {
+			s_size = p_size;
+			s_count = 0;
+			s_bitIndex = 0;
+			s_overflow = BitBuffer::OVERFLOW_SKIP;
+			s_data = (byte*)malloc(((unsigned long) p_size * RECORD_SIZE + 7) / 8);
+		}
+
+		// ##### METHODS #####
+		/*
+		 * Resets buffer instance and frees memory
+		 */
+		void flush() {
+			free(s_data);
+			s_data = NULL;
+			s_size = 0;
+			s_count = 0;
+		}
+
+		/*
+		 * Overflow handling per field, see BitBuffer
+		 * OVERFLOW_SKIP skips the whole record if one of its fields is beyond its width
+		 */
+		byte getOverflowState() {
+			return s_overflow;
+		}
+
+		void setOverflowState(byte p_overflow) {
+			s_overflow = p_overflow;
+		}
+
+		// returns capacity of records / number of records currently stored in buffer
+		unsigned int getSize() {
+			return s_size;
+		}
+
+		unsigned int getRecordCount() {
+			return s_count;
+		}
+
+		// returns the width / offset of the field in bits
+		static constexpr byte getFieldWidth(byte p_field) {
+			return Layout::getWidth(p_field);
+		}
+
+		static constexpr byte getFieldOffset(byte p_field) {
+			return Layout::getOffset(p_field);
+		}
+
+		/*
+		 * Central methods for filling and retrieving records, the FIFO replaces the oldest record once capacity is reached.
+		 * p_fields: array of FIELD_COUNT values, one per field in order of the template parameters
+		 *
+		 * returns: whether record was stored / retrieved
+		 */
+		boolean pushRecord(const unsigned int* p_fields) {
+			//no memory could be allocated or no capacity requested
+			if(s_size == 0 || s_data == NULL)
+				return false;
+
+			uint32_t record = 0;
+
+			for(byte field = 0; field < FIELD_COUNT; field++)
+			{
+				unsigned int value = p_fields[field];
+				if(!BitBuffer::mapToRange(&value, getMaxFieldValue(field), s_overflow))
+					return false;
+
+				record |= (uint32_t) value << (RECORD_SIZE - getFieldOffset(field) - getFieldWidth(field));
+			}
+
+			writeRecord(s_bitIndex, record);
+
+			s_bitIndex += RECORD_SIZE;
+			if(s_bitIndex >= (unsigned long) s_size * RECORD_SIZE)
+				s_bitIndex = 0;
+			if(s_count < s_size)
+				s_count++;
+
+			return true;
+		}
+
+		boolean popRecord(unsigned int* p_fields) {
+			if(!getRecord(1, p_fields))
+				return false;
+
+			s_count--;
+			return true;
+		}
+
+		/*
+		 * Returns the record / a single field of the record at the specified index in FIFO without deleting it.
+		 *
+		 * p_index: index in FIFO starting with 1
+		 * returns: whether record was retrieved / value of field or 0 in case of invalid index
+		 */
+		boolean getRecord(unsigned int p_index, unsigned int* p_fields) {
+			if(s_size == 0 || s_data == NULL || p_index < 1 || p_index > s_count)
+				return false;
+
+			uint32_t record = readRecord(getBitIndex(p_index));
+
+			for(byte field = 0; field < FIELD_COUNT; field++)
+				p_fields[field] = extractField(record, field);
+
+			return true;
+		}
+
+		unsigned int getField(unsigned int p_index, byte p_field) {
+			if(s_size == 0 || s_data == NULL || p_index < 1 || p_index > s_count || p_field >= FIELD_COUNT)
+				return 0;
+
+			BitReader reader(s_data, getBitIndex(p_index) + getFieldOffset(p_field), 0);
+			return reader.read(getFieldWidth(p_field));
+		}
+
+		/*
+		 * Bulk extraction of one field of p_count records starting at the specified index in FIFO, e.g. for analyzing one field.
+		 * Records are streamed through one reader in FIFO order, wrapping at the end of the buffer.
+		 *
+		 * p_index: index in FIFO starting with 1
+		 * returns: number of values written to p_values
+		 */
+		unsigned int getColumn(byte p_field, unsigned int p_index, unsigned int* p_values, unsigned int p_count) {
+			if(s_size == 0 || s_data == NULL || p_index < 1 || p_index > s_count || p_field >= FIELD_COUNT)
+				return 0;
+
+			if(p_count > s_count - p_index + 1)
+				p_count = s_count - p_index + 1;
+
+			BitReader reader(s_data, getBitIndex(p_index), (unsigned long) s_size * RECORD_SIZE);
+
+			for(unsigned int i = 0; i < p_count; i++)
+				p_values[i] = extractField(readRecord(reader), p_field);
+
+			return p_count;
+		}
+
+	private:
+		// ###### VARIABLES #####
+		byte* s_data; //dataset array
+		unsigned long s_bitIndex; //location index for next write on bitlevel
+		unsigned int s_size; //capacity of records
+		unsigned int s_count; //number of records stored
+		byte s_overflow; //overflow behaviour
+
+		// ##### METHODS #####
+		// returns the maximum value of the field
+		static constexpr unsigned int getMaxFieldValue(byte p_field) {
+			return (unsigned int) ((1UL << getFieldWidth(p_field)) - 1);
+		}
+
+		// returns the field from the packed record
+		static unsigned int extractField(uint32_t p_record, byte p_field) {
+			return (p_record >> (RECORD_SIZE - getFieldOffset(p_field) - getFieldWidth(p_field))) & getMaxFieldValue(p_field);
+		}
+
+		// maps the index in FIFO (starting with 1) to the bit index of the record in the byte array
+		unsigned long getBitIndex(unsigned int p_index) {
+			unsigned long bitDelta = (unsigned long) (s_count - p_index + 1) * RECORD_SIZE;
+
+			if(bitDelta <= s_bitIndex)
+				return s_bitIndex - bitDelta;
+
+			return (unsigned long) s_size * RECORD_SIZE - bitDelta + s_bitIndex;
+		}
+
+		// writes / reads the packed record as one or two 16 bit parts
+		void writeRecord(unsigned long p_bitIndex, uint32_t p_record) {
+			BitWriter writer(s_data, p_bitIndex, 0);
+
+			if(RECORD_SIZE > 16)
+				writer.write(p_record >> 16, RECORD_SIZE - 16);
+			writer.write(p_record, RECORD_SIZE > 16 ? 16 : RECORD_SIZE);
+			writer.flush();
+		}
+
+		uint32_t readRecord(unsigned long p_bitIndex) {
+			BitReader reader(s_data, p_bitIndex, 0);
+			return readRecord(reader);
+		}
+
+		uint32_t readRecord(BitReader& p_reader) {
+			uint32_t record = 0;
+
+			if(RECORD_SIZE > 16)
+				record = (uint32_t) p_reader.read(RECORD_SIZE - 16) << 16;
+			return record | p_reader.read(RECORD_SIZE > 16 ? 16 : RECORD_SIZE);
+		}
+};
+
+#endif
@@ -0,0 +1,206 @@
+/*
+ *	Arduino BitBuffer - bit-sliced segment
+ *	vertical storage of values for fast predicate scans, see BitSlicedSegment.h
+ */
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "BitSlicedSegment.h"
+
+/*
+ * Constructor
+ * p_range - defines the max values to be stored in the segment, use the public constants of BitBuffer
+ * p_size - defines the number of values the segment can hold
+ */
+BitSlicedSegment::BitSlicedSegment(byte p_range, unsigned int p_size) {
+	s_size = p_size;
+	s_count = 0;
+	s_maxValue = BitBuffer::getMaxRangeValue(p_range);
+	s_bitSize = BitBuffer::getBitSize(p_range);
+
+	s_data = (uint32_t*)calloc((unsigned long) getGroupCount() * s_bitSize, sizeof(uint32_t));
+
+	#if BB_DEBUG_LEVEL > 0
+	Serial.print("BitSlicedSegment::Word count: ");
+	Serial.println((unsigned long) getGroupCount() * s_bitSize);
+	#endif
+}
+
+/*
+ * Resets segment instance and frees memory
+ */
+void BitSlicedSegment::flush() {
+	free(s_data);
+	s_data = NULL;
+	s_size = 0;
+	s_count = 0;
+}
+
+// returns capacity of values / number of values currently stored in segment
+unsigned int BitSlicedSegment::getSize() {
+	return s_size;
+}
+
+unsigned int BitSlicedSegment::getValueCount() {
+	return s_count;
+}
+
+/*
+ * Moves up to getSize() values from the buffer into the segment replacing its values
+ * values are popped by 32 at once and each group is transposed into its bit words
+ *
+ * returns: number of values moved
+ */
+unsigned int BitSlicedSegment::seal(BitBuffer* p_buffer) {
+	unsigned int values[32];
+
+	memset(s_data, 0, (unsigned long) getGroupCount() * s_bitSize * sizeof(uint32_t));
+	s_count = 0;
+
+	for(unsigned int group = 0; group < getGroupCount(); group++)
+	{
+		unsigned int count = s_size - s_count < 32 ? s_size - s_count : 32;
+		count = p_buffer->pop(values, count);
+
+		uint32_t* words = &s_data[group * s_bitSize];
+		for(byte k = 0; k < count; k++)
+		{
+			for(byte j = 0; j < s_bitSize; j++)
+			{
+				if(values[k] & (1U << (s_bitSize - 1 - j)))
+					words[j] |= 0x80000000UL >> k;
+			}
+		}
+
+		s_count += count;
+		if(count < 32)
+			break;
+	}
+
+	#if BB_DEBUG_LEVEL > 1
+	Serial.print("BitSlicedSegment::Sealed values: ");
+	Serial.println(s_count);
+	#endif
+
+	return s_count;
+} //END seal
+
+// pushes the values of the segment in the same order back into the buffer
+unsigned int BitSlicedSegment::unseal(BitBuffer* p_buffer) {
+	unsigned int count = 0;
+
+	for(unsigned int i = 0; i < s_count; i++)
+	{
+		if(p_buffer->push(getValue(i)))
+			count++;
+	}
+
+	return count;
+}
+
+/*
+ * Returns the value, p_index starting with 0 for the first value sealed
+ */
+unsigned int BitSlicedSegment::getValue(unsigned int p_index) {
+	if(p_index >= s_count)
+		return 0;
+
+	uint32_t* words = &s_data[(p_index / 32) * s_bitSize];
+	uint32_t mask = 0x80000000UL >> (p_index % 32);
+	unsigned int ret = 0;
+
+	for(byte j = 0; j < s_bitSize; j++)
+	{
+		ret <<= 1;
+		if(words[j] & mask)
+			ret |= 1;
+	}
+
+	return ret;
+}
+
+/*
+ * Predicate scan over all values in segment, see BitBuffer::scan for operators and bitmap
+ * The bit words of a group are compared starting with the most significant bit, a value is less than the constant
+ * once its bit is 0 where the one of the constant is 1 with all more significant bits being equal. Each step
+ * decides this for all 32 values of the group at once. The result of a group is the bitmap of its 32 values.
+ *
+ * returns: number of values matching
+ */
+unsigned int BitSlicedSegment::scan(byte p_operator, unsigned int p_value, unsigned int p_upper, byte* p_bitmap) {
+	unsigned int count = 0;
+
+	//constants beyond the range are decided without comparison, values of the segment never exceed it
+	boolean always = p_value > s_maxValue && (p_operator == BitBuffer::SCAN_NOT_EQUAL || p_operator == BitBuffer::SCAN_LESS);
+	boolean never = (p_value > s_maxValue && !always) || (p_operator == BitBuffer::SCAN_BETWEEN && p_value > p_upper);
+	if(p_upper > s_maxValue)
+		p_upper = s_maxValue;
+
+	for(unsigned int group = 0; group * 32 < s_count; group++)
+	{
+		uint32_t* words = &s_data[group * s_bitSize];
+		uint32_t equal = 0xFFFFFFFFUL;
+		uint32_t less = 0;
+		uint32_t equalUpper = 0xFFFFFFFFUL;
+		uint32_t greater = 0;
+
+		for(byte j = 0; j < s_bitSize && !always && !never; j++)
+		{
+			byte bit = s_bitSize - 1 - j;
+			uint32_t value = (p_value >> bit) & 0x01 ? 0xFFFFFFFFUL : 0;
+			uint32_t upper = (p_upper >> bit) & 0x01 ? 0xFFFFFFFFUL : 0;
+
+			less |= equal & ~words[j] & value;
+			equal &= ~(words[j] ^ value);
+			greater |= equalUpper & words[j] & ~upper;
+			equalUpper &= ~(words[j] ^ upper);
+		}
+
+		uint32_t match;
+		if(always || never)
+			match = always ? 0xFFFFFFFFUL : 0;
+		else if(p_operator == BitBuffer::SCAN_EQUAL)
+			match = equal;
+		else if(p_operator == BitBuffer::SCAN_NOT_EQUAL)
+			match = ~equal;
+		else if(p_operator == BitBuffer::SCAN_LESS)
+			match = less;
+		else
+			match = ~(less | greater);
+
+		//mask values behind the last one of the segment
+		unsigned int valueCount = s_count - group * 32;
+		if(valueCount < 32)
+			match &= ~(0xFFFFFFFFUL >> valueCount);
+		else
+			valueCount = 32;
+
+		count += __builtin_popcountl(match);
+
+		if(p_bitmap != NULL)
+		{
+			for(byte i = 0; i * 8 < valueCount; i++)
+				p_bitmap[group * 4 + i] = match >> (24 - i * 8);
+		}
+	}
+
+	#if BB_DEBUG_LEVEL > 1
+	Serial.print("BitSlicedSegment::Matching values: ");
+	Serial.println(count);
+	#endif
+
+	return count;
+} //END scan
+
+/*####################################
+ *      INTERNAL PROCESSING METHODS
+ *####################################
+ */
+// returns the number of groups of 32 values
+unsigned int BitSlicedSegment::getGroupCount() {
+	return (s_size + 31) / 32;
+}
@@ -0,0 +1,76 @@
+/*
+ *	Arduino BitBuffer - bit-sliced segment
+ *	BitSlicedSegment stores values of a BitBuffer range vertically: values are grouped by 32 and bit j of all values
+ *	of a group is stored in one 32 bit word, the value k of a group in bit 31-k of each word. Comparing the values of a
+ *	group against a constant takes getBitSize() word operations for all 32 values at once, independent of the value size.
+ *
+ *	Segments are sealed from the values of a BitBuffer, e.g. once the buffer is full, and scanned afterwards.
+ *	Appending single values is more expensive than in BitBuffer as every bit goes to a different word.
+ */
+
+#ifndef BitSlicedSegment_h
+#define BitSlicedSegment_h
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "BitBuffer.h"
+
+class BitSlicedSegment
+{
+	public:
+		// ##### CONSTRUCTOR #####
+		/*
+		 * p_range - defines the max values to be stored in the segment, use the public constants of BitBuffer
+		 * p_size - defines the number of values the segment can hold
+		 */
+		BitSlicedSegment(byte p_range, unsigned int p_size);
+
+		// ##### METHODS #####
+		/*
+		 * Resets segment instance and frees memory
+		 */
+		void flush();
+
+		// returns capacity of values / number of values currently stored in segment
+		unsigned int getSize();
+		unsigned int getValueCount();
+
+		/*
+		 * Moves up to getSize() values from the buffer into the segment replacing its values, the values are popped from buffer in FIFO order.
+		 * unseal pushes the values of the segment in the same order back into the buffer.
+		 * The buffer is expected to have the same range as the segment.
+		 *
+		 * returns: number of values moved
+		 */
+		unsigned int seal(BitBuffer* p_buffer);
+		unsigned int unseal(BitBuffer* p_buffer);
+
+		/*
+		 * Returns the value, p_index starting with 0 for the first value sealed
+		 */
+		unsigned int getValue(unsigned int p_index);
+
+		/*
+		 * Predicate scan over all values in segment, see BitBuffer::scan for operators and bitmap
+		 * returns: number of values matching
+		 */
+		unsigned int scan(byte p_operator, unsigned int p_value, unsigned int p_upper = 0, byte* p_bitmap = NULL);
+
+	private:
+		// ###### VARIABLES #####
+		uint32_t* s_data; //dataset array, getBitSize() words per group of 32 values starting with the most significant bit
+		unsigned int s_size; //capacity of values
+		unsigned int s_count; //number of values stored
+		unsigned int s_maxValue; //maximum value for defined range
+		byte s_bitSize; //number of bits per value
+
+		// ##### METHODS #####
+		// returns the number of groups of 32 values
+		unsigned int getGroupCount();
+};
+
+#endif
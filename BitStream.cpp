@@ -0,0 +1,128 @@
+/*
+ *	Arduino BitBuffer - bit stream primitives
+ *	BitWriter and BitReader pack and unpack a sequence of values with variable bit sizes into a byte array
+ *	by keeping an accumulator of pending bits, see BitStream.h
+ */
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "BitStream.h"
+
+/*####################################
+ *      BitWriter
+ *####################################
+ */
+BitWriter::BitWriter(byte* p_data, unsigned long p_bitIndex, unsigned long p_bitLimit) {
+	s_data = p_data;
+	s_bitLimit = p_bitLimit;
+
+	seek(p_bitIndex);
+}
+
+/*
+ * Appends the lower p_bitSize bits of p_value (1 to 16 bits) to the stream.
+ * value stored before: 110xxxxx, pending bits: 110, value new: 01111, after write: 11001111
+ */
+void BitWriter::write(unsigned int p_value, byte p_bitSize) {
+	//values are never split at the limit, continue at the beginning
+	if(s_bitLimit > 0 && s_bitIndex + p_bitSize > s_bitLimit)
+	{
+		flush();
+		seek(0);
+	}
+
+	s_buffer = (s_buffer << p_bitSize) | (p_value & ((1UL << p_bitSize) - 1));
+	s_bufferBits += p_bitSize;
+	s_bitIndex += p_bitSize;
+
+	//store all completed bytes, at most 7 bits remain pending
+	while(s_bufferBits >= 8)
+	{
+		s_bufferBits -= 8;
+		s_data[s_byteIndex++] = (byte) (s_buffer >> s_bufferBits);
+	}
+}
+
+/*
+ * Writes pending bits of a partially filled byte to the byte array, the following bits of this byte are kept.
+ * pending bits: 110, value stored before: xxx10101, after flush: 11010101
+ */
+void BitWriter::flush() {
+	if(s_bufferBits == 0)
+		return;
+
+	byte mask = 0xFF >> s_bufferBits;
+	s_data[s_byteIndex] = (byte) (s_buffer << (8 - s_bufferBits)) | (s_data[s_byteIndex] & mask);
+}
+
+// continues writing at the defined bit index, pending bits not flushed before are discarded
+void BitWriter::seek(unsigned long p_bitIndex) {
+	s_bitIndex = p_bitIndex;
+	s_byteIndex = p_bitIndex / 8;
+	s_bufferBits = p_bitIndex % 8;
+
+	//bits in front of the bit index belong to other values and are kept as pending bits
+	if(s_bufferBits > 0)
+		s_buffer = s_data[s_byteIndex] >> (8 - s_bufferBits);
+	else
+		s_buffer = 0;
+}
+
+// returns the bit index the next value will be written to
+unsigned long BitWriter::getBitIndex() {
+	return s_bitIndex;
+}
+
+/*####################################
+ *      BitReader
+ *####################################
+ */
+BitReader::BitReader(const byte* p_data, unsigned long p_bitIndex, unsigned long p_bitLimit) {
+	s_data = p_data;
+	s_bitLimit = p_bitLimit;
+
+	seek(p_bitIndex);
+}
+
+// returns the next p_bitSize bits (1 to 16 bits) of the stream
+unsigned int BitReader::read(byte p_bitSize) {
+	//values are never split at the limit, continue at the beginning
+	if(s_bitLimit > 0 && s_bitIndex + p_bitSize > s_bitLimit)
+		seek(0);
+
+	//only load the bytes required for this value, at most 23 bits are held in accumulator
+	while(s_bufferBits < p_bitSize)
+	{
+		s_buffer = (s_buffer << 8) | s_data[s_byteIndex++];
+		s_bufferBits += 8;
+	}
+
+	s_bufferBits -= p_bitSize;
+	s_bitIndex += p_bitSize;
+
+	return (unsigned int) ((s_buffer >> s_bufferBits) & ((1UL << p_bitSize) - 1));
+}
+
+// continues reading at the defined bit index
+void BitReader::seek(unsigned long p_bitIndex) {
+	s_bitIndex = p_bitIndex;
+	s_byteIndex = p_bitIndex / 8;
+	s_buffer = 0;
+	s_bufferBits = 0;
+
+	//load the byte the bit index points to and drop the bits in front of it
+	if(p_bitIndex % 8 > 0)
+	{
+		s_buffer = s_data[s_byteIndex++];
+		s_bufferBits = 8 - p_bitIndex % 8;
+	}
+}
+
+// returns the bit index of the next value to be read
+unsigned long BitReader::getBitIndex() {
+	return s_bitIndex;
+}
@@ -0,0 +1,92 @@
+/*
+ *	Arduino BitBuffer - bit stream primitives
+ *	BitWriter and BitReader pack and unpack a sequence of values with variable bit sizes into a byte array.
+ *	Instead of building byte masks for every value both keep an accumulator of pending bits and only
+ *	access the byte array once a whole byte was collected (write) or is required (read). The bit order
+ *	corresponds to BitBuffer, the first value starts at the most significant bit of the first byte.
+ *
+ *	Both optionally wrap at a bit limit to continue at bit index 0, which allows streaming through the
+ *	ring of a BitBuffer. A value is never split at the bit limit, the stream wraps before it instead.
+ */
+
+#ifndef BitStream_h
+#define BitStream_h
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+class BitWriter
+{
+	public:
+		// ##### CONSTRUCTOR #####
+		/*
+		 * p_data - byte array the values are written to
+		 * p_bitIndex - bit index the first value is written to
+		 * p_bitLimit - bit index on which writing continues at bit index 0, 0 for no wrap
+		 */
+		BitWriter(byte* p_data, unsigned long p_bitIndex, unsigned long p_bitLimit);
+
+		// ##### METHODS #####
+		/*
+		 * Appends the lower p_bitSize bits of p_value (1 to 16 bits) to the stream.
+		 * Bits are kept in the accumulator until a whole byte is available, call flush to write the remaining bits.
+		 */
+		void write(unsigned int p_value, byte p_bitSize);
+
+		/*
+		 * Writes pending bits of a partially filled byte to the byte array, the following bits of this byte are kept.
+		 * Writing can be continued afterwards.
+		 */
+		void flush();
+
+		// continues writing at the defined bit index, pending bits not flushed before are discarded
+		void seek(unsigned long p_bitIndex);
+
+		// returns the bit index the next value will be written to
+		unsigned long getBitIndex();
+
+	private:
+		// ###### VARIABLES #####
+		byte* s_data; //dataset array
+		unsigned long s_bitIndex; //location index for next write on bitlevel
+		unsigned long s_bitLimit; //location index on which stream wraps to 0, 0 for no wrap
+		unsigned int s_byteIndex; //array index the pending bits belong to
+		unsigned long s_buffer; //accumulator, lower s_bufferBits bits are pending
+		byte s_bufferBits; //number of pending bits in accumulator
+};
+
+class BitReader
+{
+	public:
+		// ##### CONSTRUCTOR #####
+		/*
+		 * p_data - byte array the values are read from
+		 * p_bitIndex - bit index of the first value
+		 * p_bitLimit - bit index on which reading continues at bit index 0, 0 for no wrap
+		 */
+		BitReader(const byte* p_data, unsigned long p_bitIndex, unsigned long p_bitLimit);
+
+		// ##### METHODS #####
+		// returns the next p_bitSize bits (1 to 16 bits) of the stream
+		unsigned int read(byte p_bitSize);
+
+		// continues reading at the defined bit index
+		void seek(unsigned long p_bitIndex);
+
+		// returns the bit index of the next value to be read
+		unsigned long getBitIndex();
+
+	private:
+		// ###### VARIABLES #####
+		const byte* s_data; //dataset array
+		unsigned long s_bitIndex; //location index for next read on bitlevel
+		unsigned long s_bitLimit; //location index on which stream wraps to 0, 0 for no wrap
+		unsigned int s_byteIndex; //array index of the next byte to be loaded into accumulator
+		unsigned long s_buffer; //accumulator, lower s_bufferBits bits are not yet read
+		byte s_bufferBits; //number of bits in accumulator not yet read
+};
+
+#endif
@@ -0,0 +1,219 @@
+/*
+ *	Arduino BitBuffer - Count-Min sketch
+ *	frequency estimation with packed counters, see CountMinSketch.h
+ */
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "CountMinSketch.h"
+#include "BitStream.h"
+
+// counters of all rows are requested before the first one is read where the target supports prefetching
+#if defined(__GNUC__) && !defined(__AVR__)
+#define BB_PREFETCH(address) __builtin_prefetch(address)
+#else
+#define BB_PREFETCH(address)
+#endif
+
+// static constant for overflow state
+const byte CountMinSketch::OVERFLOW_HALVE = 0x04;
+
+/*
+ * Constructor
+ * p_range - defines the max value of a counter, use the public constants of BitBuffer
+ * p_depth - defines the number of rows, at most BB_SKETCH_MAX_DEPTH
+ * p_width - defines the number of counters per row
+ */
+CountMinSketch::CountMinSketch(byte p_range, byte p_depth, unsigned int p_width) {
+	if(p_depth < 1)
+		p_depth = 1;
+	else if(p_depth > BB_SKETCH_MAX_DEPTH)
+		p_depth = BB_SKETCH_MAX_DEPTH;
+
+	s_depth = p_depth;
+	s_width = p_width;
+	s_maxValue = BitBuffer::getMaxRangeValue(p_range);
+	s_bitSize = BitBuffer::getBitSize(p_range);
+	s_overflow = BitBuffer::OVERFLOW_MAX;
+
+	s_data = (byte*)calloc(((unsigned long) s_depth * s_width * s_bitSize + 7) / 8, 1);
+
+	#if BB_DEBUG_LEVEL > 0
+	Serial.print("CountMinSketch::Array size: ");
+	Serial.println(((unsigned long) s_depth * s_width * s_bitSize + 7) / 8);
+	#endif
+}
+
+/*
+ * Resets sketch instance and frees memory
+ */
+void CountMinSketch::flush() {
+	free(s_data);
+	s_data = NULL;
+	s_width = 0;
+}
+
+/*
+ * Overflow handling when a counter would exceed the range
+ */
+byte CountMinSketch::getOverflowState() {
+	return s_overflow;
+}
+
+void CountMinSketch::setOverflowState(byte p_overflow) {
+	s_overflow = p_overflow;
+}
+
+// returns the number of rows / counters per row
+byte CountMinSketch::getDepth() {
+	return s_depth;
+}
+
+unsigned int CountMinSketch::getWidth() {
+	return s_width;
+}
+
+// sets all counters to 0
+void CountMinSketch::reset() {
+	memset(s_data, 0, ((unsigned long) s_depth * s_width * s_bitSize + 7) / 8);
+}
+
+/*
+ * Adds p_count occurrences of the key
+ * the estimate is raised by p_count and only counters below the new estimate are set to it (conservative update)
+ * returns: estimated frequency of the key after update
+ */
+unsigned int CountMinSketch::update(uint32_t p_key, unsigned int p_count) {
+	if(s_width == 0)
+		return 0;
+
+	unsigned long bitIndex[BB_SKETCH_MAX_DEPTH];
+	for(byte row = 0; row < s_depth; row++)
+	{
+		bitIndex[row] = getBitIndex(row, p_key);
+		BB_PREFETCH(&s_data[bitIndex[row] / 8]);
+	}
+
+	unsigned int current = s_maxValue;
+	for(byte row = 0; row < s_depth; row++)
+	{
+		unsigned int counter = getCounter(bitIndex[row]);
+		if(counter < current)
+			current = counter;
+	}
+
+	if(p_count > s_maxValue - current && s_overflow == OVERFLOW_HALVE)
+	{
+		halve();
+		current /= 2;
+	}
+
+	unsigned int target = p_count > s_maxValue - current ? s_maxValue : current + p_count;
+
+	for(byte row = 0; row < s_depth; row++)
+	{
+		if(getCounter(bitIndex[row]) < target)
+			setCounter(bitIndex[row], target);
+	}
+
+	return target;
+} //END update
+
+/*
+ * Adds one occurrence of each of p_count keys
+ */
+void CountMinSketch::update(const uint32_t* p_keys, unsigned int p_count) {
+	for(unsigned int i = 0; i < p_count; i++)
+		update(p_keys[i], 1);
+}
+
+/*
+ * Returns the estimated frequency of the key
+ */
+unsigned int CountMinSketch::estimate(uint32_t p_key) {
+	unsigned int ret = 0;
+	estimate(&p_key, 1, &ret);
+	return ret;
+}
+
+/*
+ * Writes the estimated frequency of each of p_count keys to p_estimates
+ * keys are processed row by row, the counter of the following key is requested while the current one is read
+ */
+void CountMinSketch::estimate(const uint32_t* p_keys, unsigned int p_count, unsigned int* p_estimates) {
+	for(unsigned int i = 0; i < p_count; i++)
+		p_estimates[i] = s_width == 0 ? 0 : s_maxValue;
+
+	if(s_width == 0 || p_count == 0)
+		return;
+
+	for(byte row = 0; row < s_depth; row++)
+	{
+		unsigned long bitIndex = getBitIndex(row, p_keys[0]);
+
+		for(unsigned int i = 0; i < p_count; i++)
+		{
+			unsigned long nextBitIndex = 0;
+			if(i + 1 < p_count)
+			{
+				nextBitIndex = getBitIndex(row, p_keys[i + 1]);
+				BB_PREFETCH(&s_data[nextBitIndex / 8]);
+			}
+
+			unsigned int counter = getCounter(bitIndex);
+			if(counter < p_estimates[i])
+				p_estimates[i] = counter;
+
+			bitIndex = nextBitIndex;
+		}
+	}
+} //END estimate
+
+/*####################################
+ *      INTERNAL PROCESSING METHODS
+ *####################################
+ */
+/*
+ * Returns the bit index of the counter of the key within the row
+ * multiply-shift hashing with an odd multiplier per row, the upper 16 bits of the product are scaled to the width
+ */
+unsigned long CountMinSketch::getBitIndex(byte p_row, uint32_t p_key) {
+	uint32_t seed = (0x9E3779B1UL + (uint32_t) p_row * 0x7F4A7C16UL) | 1;
+	uint32_t hash = (p_key ^ (p_key >> 15)) * seed;
+	unsigned long column = ((hash >> 16) * (uint32_t) s_width) >> 16;
+
+	return ((unsigned long) p_row * s_width + column) * s_bitSize;
+}
+
+// returns / sets the counter at the bit index
+unsigned int CountMinSketch::getCounter(unsigned long p_bitIndex) {
+	BitReader reader(s_data, p_bitIndex, 0);
+	return reader.read(s_bitSize);
+}
+
+void CountMinSketch::setCounter(unsigned long p_bitIndex, unsigned int p_value) {
+	BitWriter writer(s_data, p_bitIndex, 0);
+	writer.write(p_value, s_bitSize);
+	writer.flush();
+}
+
+/*
+ * Halves all counters, counters are streamed through one reader and writer as they keep their position
+ */
+void CountMinSketch::halve() {
+	BitReader reader(s_data, 0, 0);
+	BitWriter writer(s_data, 0, 0);
+
+	for(unsigned long i = (unsigned long) s_depth * s_width; i > 0; i--)
+		writer.write(reader.read(s_bitSize) >> 1, s_bitSize);
+
+	writer.flush();
+
+	#if BB_DEBUG_LEVEL > 1
+	Serial.println("CountMinSketch::Counters halved");
+	#endif
+}
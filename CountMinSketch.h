@@ -0,0 +1,105 @@
+/*
+ *	Arduino BitBuffer - Count-Min sketch
+ *	CountMinSketch estimates the frequency of keys in a stream, e.g. to detect heavy hitters, with p_depth rows of
+ *	p_width counters. Each row maps a key to one counter by its own hash function, the estimate is the minimum of
+ *	the counters of all rows. Counters are packed within a defined range like the values of BitBuffer, so a
+ *	12 bit counter takes 12 bits instead of a full integer.
+ *
+ *	Counters are updated conservatively: only the counters below the new estimate of the key are raised, which
+ *	reduces the overestimation compared to incrementing every row.
+ */
+
+#ifndef CountMinSketch_h
+#define CountMinSketch_h
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "BitBuffer.h"
+
+// maximum number of rows, the index of each row is kept on the stack during update
+#define BB_SKETCH_MAX_DEPTH 8
+
+class CountMinSketch
+{
+	public:
+		// ##### static constANTS #####
+		// static constant for overflow state in addition to BitBuffer::OVERFLOW_MAX
+		static const byte OVERFLOW_HALVE;
+
+		// ##### CONSTRUCTOR #####
+		/*
+		 * p_range - defines the max value of a counter, use the public constants of BitBuffer
+		 * p_depth - defines the number of rows, at most BB_SKETCH_MAX_DEPTH
+		 * p_width - defines the number of counters per row
+		 */
+		CountMinSketch(byte p_range, byte p_depth, unsigned int p_width);
+
+		// ##### METHODS #####
+		/*
+		 * Resets sketch instance and frees memory
+		 */
+		void flush();
+
+		/*
+		 * Overflow handling when a counter would exceed the range
+		 * BitBuffer::OVERFLOW_MAX - counter stays at the maximum value of the range
+		 * OVERFLOW_HALVE - all counters are halved before the update, keeping the ratio between keys
+		 */
+		byte getOverflowState();
+		void setOverflowState(byte p_overflow);
+
+		// returns the number of rows / counters per row
+		byte getDepth();
+		unsigned int getWidth();
+
+		// sets all counters to 0
+		void reset();
+
+		/*
+		 * Adds p_count occurrences of the key
+		 * returns: estimated frequency of the key after update
+		 */
+		unsigned int update(uint32_t p_key, unsigned int p_count = 1);
+
+		/*
+		 * Adds one occurrence of each of p_count keys
+		 */
+		void update(const uint32_t* p_keys, unsigned int p_count);
+
+		/*
+		 * Returns the estimated frequency of the key
+		 */
+		unsigned int estimate(uint32_t p_key);
+
+		/*
+		 * Writes the estimated frequency of each of p_count keys to p_estimates
+		 * keys are processed row by row, so counters of one row are read one after another
+		 */
+		void estimate(const uint32_t* p_keys, unsigned int p_count, unsigned int* p_estimates);
+
+	private:
+		// ###### VARIABLES #####
+		byte* s_data; //dataset array, rows stored one after another
+		unsigned int s_width; //number of counters per row
+		unsigned int s_maxValue; //maximum value of a counter
+		byte s_depth; //number of rows
+		byte s_bitSize; //number of bits per counter
+		byte s_overflow; //overflow handling
+
+		// ##### METHODS #####
+		// returns the bit index of the counter of the key within the row
+		unsigned long getBitIndex(byte p_row, uint32_t p_key);
+
+		// returns / sets the counter at the bit index
+		unsigned int getCounter(unsigned long p_bitIndex);
+		void setCounter(unsigned long p_bitIndex, unsigned int p_value);
+
+		// halves all counters
+		void halve();
+};
+
+#endif
@@ -0,0 +1,188 @@
+/*
+ *	Arduino BitBuffer - HyperLogLog
+ *	cardinality estimation with packed 6 bit registers, see HyperLogLog.h
+ */
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "HyperLogLog.h"
+#include "BitStream.h"
+#include "math.h"
+
+// number of bits and maximum value per register
+#define BB_HLL_BIT_SIZE 6
+#define BB_HLL_MAX_RANK 0x3F
+
+// most significant bit of each of the four registers of a 24 bit group
+#define BB_HLL_GROUP_HIGH_BITS 0x820820UL
+
+/*
+ * Constructor
+ * p_precision - defines the number of registers 2^p_precision, between 4 (16 registers) and 14 (16384 registers)
+ */
+HyperLogLog::HyperLogLog(byte p_precision) {
+	if(p_precision < 4)
+		p_precision = 4;
+	else if(p_precision > 14)
+		p_precision = 14;
+
+	s_precision = p_precision;
+	s_data = (byte*)calloc(getArraySize(), 1);
+
+	#if BB_DEBUG_LEVEL > 0
+	Serial.print("HyperLogLog::Array size: ");
+	Serial.println(getArraySize());
+	#endif
+}
+
+/*
+ * Resets sketch instance and frees memory
+ */
+void HyperLogLog::flush() {
+	free(s_data);
+	s_data = NULL;
+}
+
+// returns the number of registers
+unsigned int HyperLogLog::getSize() {
+	return 1U << s_precision;
+}
+
+// sets all registers to 0
+void HyperLogLog::reset() {
+	memset(s_data, 0, getArraySize());
+}
+
+/*
+ * Returns the register, p_index starting with 0
+ */
+byte HyperLogLog::getValue(unsigned int p_index) {
+	if(p_index >= getSize())
+		return 0;
+
+	BitReader reader(s_data, (unsigned long) p_index * BB_HLL_BIT_SIZE, 0);
+	return reader.read(BB_HLL_BIT_SIZE);
+}
+
+/*
+ * Sets the register to p_rank if it is larger than the current value, p_rank is limited to the register range
+ * returns: whether register was changed
+ */
+boolean HyperLogLog::updateMax(unsigned int p_index, byte p_rank) {
+	if(p_index >= getSize())
+		return false;
+
+	if(p_rank > BB_HLL_MAX_RANK)
+		p_rank = BB_HLL_MAX_RANK;
+
+	if(p_rank <= getValue(p_index))
+		return false;
+
+	BitWriter writer(s_data, (unsigned long) p_index * BB_HLL_BIT_SIZE, 0);
+	writer.write(p_rank, BB_HLL_BIT_SIZE);
+	writer.flush();
+
+	return true;
+}
+
+/*
+ * Adds an element by its 32 bit hash value
+ * the first p bits select the register, the rank is the position of the first set bit in the remaining bits
+ */
+boolean HyperLogLog::add(uint32_t p_hash) {
+	unsigned int index = p_hash >> (32 - s_precision);
+	uint32_t remaining = p_hash << s_precision;
+	byte rank = 1;
+
+	while(rank <= 32 - s_precision && (remaining & 0x80000000UL) == 0)
+	{
+		remaining <<= 1;
+		rank++;
+	}
+
+	return updateMax(index, rank);
+}
+
+/*
+ * Merges the other sketch into this one by setting each register to the maximum of both
+ * Registers are processed as groups of four in 24 bit (three bytes), the comparison is done for all four at once:
+ * with H being the most significant bit of each register, ((a | H) - (b & ~H)) compares the lower bits without
+ * borrowing across registers, combined with the most significant bits this results in H bits set where a < b.
+ */
+boolean HyperLogLog::merge(HyperLogLog* p_other) {
+	if(p_other->s_precision != s_precision)
+		return false;
+
+	for(unsigned int i = 0; i < getArraySize(); i += 3)
+	{
+		uint32_t a = ((uint32_t) s_data[i] << 16) | ((uint32_t) s_data[i + 1] << 8) | s_data[i + 2];
+		uint32_t b = ((uint32_t) p_other->s_data[i] << 16) | ((uint32_t) p_other->s_data[i + 1] << 8) | p_other->s_data[i + 2];
+
+		uint32_t difference = (a | BB_HLL_GROUP_HIGH_BITS) - (b & ~BB_HLL_GROUP_HIGH_BITS);
+		uint32_t less = ((~a & b) | (~(a ^ b) & ~difference)) & BB_HLL_GROUP_HIGH_BITS;
+
+		//spread the flag of each register to all of its bits and take the register from b where a < b
+		uint32_t mask = (less >> (BB_HLL_BIT_SIZE - 1)) * BB_HLL_MAX_RANK;
+		uint32_t merged = (a & ~mask) | (b & mask);
+
+		s_data[i] = merged >> 16;
+		s_data[i + 1] = merged >> 8;
+		s_data[i + 2] = merged;
+	}
+
+	return true;
+}
+
+/*
+ * Returns the estimated number of distinct elements added
+ * the harmonic mean of 2^-register is built from a histogram of register values, so 2^-x is calculated once per value
+ * instead of once per register; small and large cardinalities are corrected as in the original HyperLogLog paper
+ */
+float HyperLogLog::getEstimate() {
+	unsigned int histogram[BB_HLL_MAX_RANK + 1];
+	memset(histogram, 0, sizeof(histogram));
+
+	BitReader reader(s_data, 0, 0);
+	for(unsigned int i = 0; i < getSize(); i++)
+		histogram[reader.read(BB_HLL_BIT_SIZE)]++;
+
+	float sum = 0;
+	for(byte rank = 0; rank <= BB_HLL_MAX_RANK; rank++)
+	{
+		if(histogram[rank] > 0)
+			sum += ldexp(histogram[rank], -rank);
+	}
+
+	float m = getSize();
+	float alpha;
+	if(s_precision == 4)
+		alpha = 0.673;
+	else if(s_precision == 5)
+		alpha = 0.697;
+	else if(s_precision == 6)
+		alpha = 0.709;
+	else
+		alpha = 0.7213 / (1 + 1.079 / m);
+
+	float estimate = alpha * m * m / sum;
+
+	if(estimate <= 2.5 * m && histogram[0] > 0)
+		estimate = m * log(m / histogram[0]);
+	else if(estimate > 4294967296.0 / 30)
+		estimate = -4294967296.0 * log(1 - estimate / 4294967296.0);
+
+	return estimate;
+}
+
+/*####################################
+ *      INTERNAL PROCESSING METHODS
+ *####################################
+ */
+// returns the size of the byte array, always a multiple of three bytes as there are at least 16 registers
+unsigned int HyperLogLog::getArraySize() {
+	return (getSize() / 4) * 3;
+}
@@ -0,0 +1,79 @@
+/*
+ *	Arduino BitBuffer - HyperLogLog
+ *	HyperLogLog estimates the number of distinct elements (cardinality) of a stream with a fixed number of
+ *	registers. Registers are 6 bit wide like values of BitBuffer::RANGE64 and stored packed, saving 25% compared
+ *	to one byte per register. Four registers form a 24 bit group, which lets merge compute the register-wise
+ *	maximum of two sketches for four registers at once (SWAR) instead of unpacking every register.
+ *
+ *	Elements are added by a 32 bit hash value of the element, the first p bits select the register.
+ */
+
+#ifndef HyperLogLog_h
+#define HyperLogLog_h
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "BitBuffer.h"
+
+class HyperLogLog
+{
+	public:
+		// ##### CONSTRUCTOR #####
+		/*
+		 * p_precision - defines the number of registers 2^p_precision, between 4 (16 registers) and 14 (16384 registers)
+		 */
+		HyperLogLog(byte p_precision);
+
+		// ##### METHODS #####
+		/*
+		 * Resets sketch instance and frees memory
+		 */
+		void flush();
+
+		// returns the number of registers
+		unsigned int getSize();
+
+		// sets all registers to 0
+		void reset();
+
+		/*
+		 * Returns the register, p_index starting with 0
+		 */
+		byte getValue(unsigned int p_index);
+
+		/*
+		 * Sets the register to p_rank if it is larger than the current value, p_rank is limited to the register range
+		 * returns: whether register was changed
+		 */
+		boolean updateMax(unsigned int p_index, byte p_rank);
+
+		/*
+		 * Adds an element by its 32 bit hash value
+		 * returns: whether sketch was changed
+		 */
+		boolean add(uint32_t p_hash);
+
+		/*
+		 * Merges the other sketch into this one by setting each register to the maximum of both
+		 * returns: whether sketches could be merged, false if the precision differs
+		 */
+		boolean merge(HyperLogLog* p_other);
+
+		// returns the estimated number of distinct elements added
+		float getEstimate();
+
+	private:
+		// ###### VARIABLES #####
+		byte* s_data; //dataset array of packed registers
+		byte s_precision; //number of bits of hash selecting the register
+
+		// ##### METHODS #####
+		// returns the size of the byte array
+		unsigned int getArraySize();
+};
+
+#endif
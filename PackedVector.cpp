@@ -0,0 +1,247 @@
+/*
+ *	Arduino BitBuffer - packed vector
+ *	growable array of packed values with random access, see PackedVector.h
+ */
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "PackedVector.h"
+#include "BitStream.h"
+
+/*
+ * Constructor
+ * p_range - defines the max values to be stored in the vector, use the public constants of BitBuffer
+ * p_capacity - defines the number of values memory is allocated for initially
+ */
+PackedVector::PackedVector(byte p_range, unsigned int p_capacity) {
+	s_range = p_range;
+	s_overflow = BitBuffer::OVERFLOW_SKIP;
+	s_bitSize = BitBuffer::getBitSize(p_range);
+	s_data = NULL;
+	s_capacity = 0;
+	s_count = 0;
+
+	reserve(p_capacity);
+}
+
+/*
+ * Resets vector instance and frees memory
+ */
+void PackedVector::flush() {
+	free(s_data);
+	s_data = NULL;
+	s_capacity = 0;
+	s_count = 0;
+}
+
+/*
+ * Overflow handling, see BitBuffer
+ */
+byte PackedVector::getOverflowState() {
+	return s_overflow;
+}
+
+void PackedVector::setOverflowState(byte p_overflow) {
+	s_overflow = p_overflow;
+}
+
+// returns the number of values memory is allocated for
+unsigned int PackedVector::getCapacity() {
+	return s_capacity;
+}
+
+// returns the number of values currently stored in vector
+unsigned int PackedVector::getValueCount() {
+	return s_count;
+}
+
+/*
+ * Random access to the values, p_index starting with 0
+ * returns: value at specified index or 0 in case of invalid index / whether value was stored
+ */
+unsigned int PackedVector::getValue(unsigned int p_index) {
+	if(p_index >= s_count)
+		return 0;
+
+	BitReader reader(s_data, (unsigned long) p_index * s_bitSize, 0);
+	return reader.read(s_bitSize);
+}
+
+boolean PackedVector::setValue(unsigned int p_index, unsigned int p_value) {
+	if(p_index >= s_count || !BitBuffer::mapToRange(&p_value, BitBuffer::getMaxRangeValue(s_range), s_overflow))
+		return false;
+
+	BitWriter writer(s_data, (unsigned long) p_index * s_bitSize, 0);
+	writer.write(p_value, s_bitSize);
+	writer.flush();
+
+	return true;
+}
+
+/*
+ * Appends the value, memory is doubled once the capacity is reached
+ */
+boolean PackedVector::push_back(unsigned int p_value) {
+	if(!BitBuffer::mapToRange(&p_value, BitBuffer::getMaxRangeValue(s_range), s_overflow) || !reserve(s_count + 1))
+		return false;
+
+	s_count++;
+	return setValue(s_count - 1, p_value);
+}
+
+/*
+ * Changes the number of values, additional values are set to 0
+ */
+boolean PackedVector::resize(unsigned int p_count) {
+	if(!reserve(p_count))
+		return false;
+
+	if(p_count > s_count)
+	{
+		BitWriter writer(s_data, (unsigned long) s_count * s_bitSize, 0);
+
+		for(unsigned long bitCount = (unsigned long) (p_count - s_count) * s_bitSize; bitCount > 0; )
+		{
+			byte bits = bitCount > 16 ? 16 : bitCount;
+			writer.write(0, bits);
+			bitCount -= bits;
+		}
+
+		writer.flush();
+	}
+
+	s_count = p_count;
+	return true;
+}
+
+/*
+ * Inserts the value in front of p_index, following values are moved by one
+ */
+boolean PackedVector::insert(unsigned int p_index, unsigned int p_value) {
+	if(p_index > s_count || !BitBuffer::mapToRange(&p_value, BitBuffer::getMaxRangeValue(s_range), s_overflow) || !reserve(s_count + 1))
+		return false;
+
+	moveBits((unsigned long) p_index * s_bitSize, (unsigned long) (p_index + 1) * s_bitSize, (unsigned long) (s_count - p_index) * s_bitSize);
+	s_count++;
+
+	return setValue(p_index, p_value);
+}
+
+/*
+ * Removes p_count values starting with p_index, following values are moved to p_index
+ */
+void PackedVector::erase(unsigned int p_index, unsigned int p_count) {
+	if(p_index >= s_count)
+		return;
+
+	if(p_count > s_count - p_index)
+		p_count = s_count - p_index;
+
+	moveBits((unsigned long) (p_index + p_count) * s_bitSize, (unsigned long) p_index * s_bitSize, (unsigned long) (s_count - p_index - p_count) * s_bitSize);
+	s_count -= p_count;
+}
+
+// iterators pointing to the first value and behind the last value
+PackedVector::Iterator PackedVector::begin() {
+	return Iterator(this, 0);
+}
+
+PackedVector::Iterator PackedVector::end() {
+	return Iterator(this, s_count);
+}
+
+/*####################################
+ *      INTERNAL PROCESSING METHODS
+ *####################################
+ */
+// grows memory to at least p_count values, at least doubling the current capacity; returns false if no memory was left
+boolean PackedVector::reserve(unsigned int p_count) {
+	if(p_count <= s_capacity)
+		return true;
+
+	unsigned int capacity = s_capacity * 2;
+	if(capacity < p_count)
+		capacity = p_count;
+
+	byte* data = (byte*)realloc(s_data, ((unsigned long) capacity * s_bitSize + 7) / 8);
+	if(data == NULL)
+		return false;
+
+	#if BB_DEBUG_LEVEL > 1
+	Serial.print("PackedVector::Grown capacity: ");
+	Serial.println(capacity);
+	#endif
+
+	s_data = data;
+	s_capacity = capacity;
+	return true;
+}
+
+/*
+ * Moves p_bitCount bits from p_fromBitIndex to p_toBitIndex, ranges may overlap (memmove on bit level)
+ * bits are moved as 16 bit words, the order depends on the direction to not overwrite bits before they are moved
+ */
+void PackedVector::moveBits(unsigned long p_fromBitIndex, unsigned long p_toBitIndex, unsigned long p_bitCount) {
+	if(p_bitCount == 0 || p_fromBitIndex == p_toBitIndex)
+		return;
+
+	if(p_toBitIndex < p_fromBitIndex)
+	{
+		//moving to the front, reader is always ahead of the bytes written
+		BitReader reader(s_data, p_fromBitIndex, 0);
+		BitWriter writer(s_data, p_toBitIndex, 0);
+
+		while(p_bitCount > 0)
+		{
+			byte bits = p_bitCount > 16 ? 16 : p_bitCount;
+			writer.write(reader.read(bits), bits);
+			p_bitCount -= bits;
+		}
+
+		writer.flush();
+	}
+	else
+	{
+		//moving to the back, words are moved starting with the last one
+		while(p_bitCount > 0)
+		{
+			byte bits = p_bitCount > 16 ? 16 : p_bitCount;
+			p_bitCount -= bits;
+
+			BitReader reader(s_data, p_fromBitIndex + p_bitCount, 0);
+			BitWriter writer(s_data, p_toBitIndex + p_bitCount, 0);
+			writer.write(reader.read(bits), bits);
+			writer.flush();
+		}
+	}
+}
+
+/*####################################
+ *      Iterator
+ *####################################
+ */
+PackedVector::Iterator::Iterator(PackedVector* p_vector, unsigned int p_index) {
+	s_vector = p_vector;
+	s_index = p_index;
+}
+
+unsigned int PackedVector::Iterator::operator*() {
+	return s_vector->getValue(s_index);
+}
+
+PackedVector::Iterator& PackedVector::Iterator::operator++() {
+	s_index++;
+	return *this;
+}
+
+boolean PackedVector::Iterator::operator==(const Iterator& p_other) {
+	return s_vector == p_other.s_vector && s_index == p_other.s_index;
+}
+
+boolean PackedVector::Iterator::operator!=(const Iterator& p_other) {
+	return !(*this == p_other);
+}
@@ -0,0 +1,123 @@
+/*
+ *	Arduino BitBuffer - packed vector
+ *	PackedVector is a growable array of values within a defined range, packed with the bits required for the
+ *	range like BitBuffer. Other than the FIFO of BitBuffer it offers random access to read and write values,
+ *	appending with capacity doubling once the allocated memory is used up, and inserting or erasing values
+ *	in between. Inserting and erasing moves the following values as a bit stream of 16 bit words instead of
+ *	value by value.
+ *
+ *	Indices start with 0. Values can be iterated with begin() and end(), e.g. for(unsigned int value : vector).
+ */
+
+#ifndef PackedVector_h
+#define PackedVector_h
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "BitBuffer.h"
+
+class PackedVector
+{
+	public:
+		// read-only iterator over the values of a PackedVector
+		class Iterator
+		{
+			public:
+				Iterator(PackedVector* p_vector, unsigned int p_index);
+
+				unsigned int operator*();
+				Iterator& operator++();
+				boolean operator==(const Iterator& p_other);
+				boolean operator!=(const Iterator& p_other);
+
+			private:
+				PackedVector* s_vector; //vector iterated
+				unsigned int s_index; //index of current value
+		};
+
+		// ##### CONSTRUCTOR #####
+		/*
+		 * p_range - defines the max values to be stored in the vector, use the public constants of BitBuffer
+		 * p_capacity - defines the number of values memory is allocated for initially
+		 */
+		PackedVector(byte p_range, unsigned int p_capacity);
+
+		// ##### METHODS #####
+		/*
+		 * Resets vector instance and frees memory
+		 */
+		void flush();
+
+		/*
+		 * Overflow handling, see BitBuffer
+		 * OVERFLOW_MAX - the maximum value for this range will be written
+		 * OVERFLOW_MIN - zero will be written
+		 * OVERFLOW_SKIP - value will not be stored
+		 */
+		byte getOverflowState();
+		void setOverflowState(byte p_overflow);
+
+		// returns the number of values memory is allocated for
+		unsigned int getCapacity();
+
+		// returns the number of values currently stored in vector
+		unsigned int getValueCount();
+
+		/*
+		 * Random access to the values, p_index starting with 0
+		 * returns: value at specified index or 0 in case of invalid index / whether value was stored
+		 */
+		unsigned int getValue(unsigned int p_index);
+		boolean setValue(unsigned int p_index, unsigned int p_value);
+
+		/*
+		 * Appends the value, memory is doubled once the capacity is reached
+		 * returns: whether value was stored, false if it was skipped or no memory was left
+		 */
+		boolean push_back(unsigned int p_value);
+
+		/*
+		 * Changes the number of values, additional values are set to 0
+		 * returns: whether number of values was changed, false if no memory was left
+		 */
+		boolean resize(unsigned int p_count);
+
+		/*
+		 * Inserts the value in front of p_index, following values are moved by one
+		 * returns: whether value was stored, false if it was skipped, p_index is invalid or no memory was left
+		 */
+		boolean insert(unsigned int p_index, unsigned int p_value);
+
+		/*
+		 * Removes p_count values starting with p_index, following values are moved to p_index
+		 */
+		void erase(unsigned int p_index, unsigned int p_count);
+
+		// iterators pointing to the first value and behind the last value
+		Iterator begin();
+		Iterator end();
+
+	private:
+		// ###### VARIABLES #####
+		byte s_range; //value range
+		byte s_overflow; //overflow behaviour
+		byte* s_data; //dataset array
+		unsigned int s_bitSize; //number of bits per value for defined range
+		unsigned int s_capacity; //number of values memory is allocated for
+		unsigned int s_count; //number of values stored in vector
+
+		// ##### METHODS #####
+		// grows memory to at least p_count values, at least doubling the current capacity; returns false if no memory was left
+		boolean reserve(unsigned int p_count);
+
+		/*
+		 * Moves p_bitCount bits from p_fromBitIndex to p_toBitIndex, ranges may overlap (memmove on bit level)
+		 */
+		void moveBits(unsigned long p_fromBitIndex, unsigned long p_toBitIndex, unsigned long p_bitCount);
+};
+
+#endif